@@ -9,6 +9,14 @@
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
+#ifdef FILESYS
+#include "filesys/directory.h"
+#include "filesys/inode.h"
+#include "filesys/page_cache.h"
+#endif
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -170,6 +178,14 @@ void disk_print_stats(void) {
                 printf("%s: %lld reads, %lld writes\n", d->name, d->read_cnt, d->write_cnt);
         }
     }
+#ifdef FILESYS
+    page_cache_print_stats();
+    dir_print_stats();
+    inode_print_stats();
+#endif
+#ifdef EFILESYS
+    fat_print_stats();
+#endif
 }
 
 /* Returns the disk numbered DEV_NO--either 0 or 1 for master or
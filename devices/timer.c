@@ -5,6 +5,7 @@
 #include <round.h>
 #include <stdio.h>
 
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
@@ -22,6 +23,9 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/** #Alarm Clock 타이머 핸들러의 thread_awake 최악 소요 사이클 */
+static uint64_t awake_cycles_max;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -112,6 +116,7 @@ void timer_nsleep(int64_t ns) {
 /* 타이머 상태 출력 */
 void timer_print_stats(void) {
     printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+    printf("Timer: worst wakeup pass %" PRIu64 " cycles\n", awake_cycles_max);
 }
 
 /* 타이머 인터럽트 핸들러 */
@@ -120,22 +125,15 @@ static void timer_interrupt(struct intr_frame *args UNUSED) {
     thread_tick();
 
     /** #Advanced Scheduler mlfqs 스케줄러의 경우 */
-    if (thread_mlfqs) {
-        mlfqs_increment();
-
-        if (!(ticks % 4)) {
-            mlfqs_recalc_priority();
-
-            if (!(ticks % TIMER_FREQ)) {
-                mlfqs_load_avg();
-                mlfqs_recalc_recent_cpu();
-            }
-        }
-    }
-
-    /** #Alarm Clock 현재 활성화되어야 하는 thread가 있는지 탐색하여 활성화 */
-    if (get_next_tick_to_awake() <= ticks)
-        thread_awake(ticks);
+    if (thread_mlfqs)
+        mlfqs_tick(ticks);
+
+    /** #Alarm Clock 타이밍 휠을 현재 틱까지 진행시켜 만료된 thread 활성화 */
+    uint64_t start = rdtsc();
+    thread_awake(ticks);
+    uint64_t cycles = rdtsc() - start;
+    if (cycles > awake_cycles_max)
+        awake_cycles_max = cycles;
 }
 
 /* loop가 1개 초과시 true 반환 */
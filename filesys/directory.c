@@ -1,7 +1,10 @@
 #include "filesys/directory.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
+#include <round.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
@@ -17,13 +20,167 @@ struct dir_entry {
 	disk_sector_t inode_sector;         /* Sector number of header. */
 	char name[NAME_MAX + 1];            /* Null terminated file name. */
 	bool in_use;                        /* In use or free? */
+	uint32_t next;                      /* Next entry on the hash chain
+	                                       or free list, 0 if none. */
 };
 
+/* A directory is laid out one sector ("block") at a time:
+ *
+ *   - Block 0 holds the struct dir_header.
+ *   - Block 1, and any later block listed in the header, holds
+ *     BUCKETS_PER_BLOCK hash chain heads.
+ *   - Every other block holds ENTRIES_PER_BLOCK entries.
+ *
+ * Entries are named by their byte offset in the directory, 0 (inside
+ * the header) meaning none.  An entry in use is on the chain of bucket
+ * hash_string (name) % bucket_cnt; a freed entry is on the free list.
+ * Entries never move, so dir_readdir() sees them in a stable order.
+ * An all-zero directory is a valid empty one. */
+#define ENTRIES_PER_BLOCK (DISK_SECTOR_SIZE / sizeof (struct dir_entry))
+#define BUCKETS_PER_BLOCK (DISK_SECTOR_SIZE / sizeof (uint32_t))
+#define BUCKET_BLK_MAX 123
+
+/* Block 0 of a directory. */
+struct dir_header {
+	uint32_t bucket_cnt;                /* Power of 2; 0 if never set up. */
+	uint32_t entry_cnt;                 /* Entries in use. */
+	uint32_t free_head;                 /* First freed entry. */
+	uint32_t next_unused;               /* Entries from here on were
+	                                       never used. */
+	uint32_t bucket_blk_cnt;            /* Number of bucket blocks. */
+	uint32_t bucket_blk[BUCKET_BLK_MAX];/* Their block numbers. */
+};
+
+/* Lookup statistics. */
+static unsigned long long lookup_cnt;   /* Calls to lookup(). */
+static unsigned long long probe_cnt;    /* Entries they examined. */
+
+/* Reads DIR's header into *H, filling in the layout of a directory
+ * that has never had an entry added. */
+static void
+read_header (const struct dir *dir, struct dir_header *h) {
+	if (inode_read_at (dir->inode, h, sizeof *h, 0) != sizeof *h)
+		memset (h, 0, sizeof *h);
+	if (h->bucket_cnt == 0) {
+		h->bucket_cnt = BUCKETS_PER_BLOCK;
+		h->bucket_blk_cnt = 1;
+		h->bucket_blk[0] = 1;
+		h->next_unused = 2 * DISK_SECTOR_SIZE;
+	}
+}
+
+/* Writes H back as DIR's header. */
+static void
+write_header (struct dir *dir, const struct dir_header *h) {
+	inode_write_at (dir->inode, h, sizeof *h, 0);
+}
+
+/* Returns true if block BLK of a directory with header H holds bucket
+ * heads rather than entries. */
+static bool
+is_bucket_block (const struct dir_header *h, size_t blk) {
+	uint32_t i;
+
+	for (i = 0; i < h->bucket_blk_cnt; i++)
+		if (h->bucket_blk[i] == blk)
+			return true;
+	return false;
+}
+
+/* Returns the byte offset of the chain head for NAME. */
+static off_t
+bucket_ofs (const struct dir_header *h, const char *name) {
+	uint32_t bucket = hash_string (name) & (h->bucket_cnt - 1);
+
+	return h->bucket_blk[bucket / BUCKETS_PER_BLOCK] * DISK_SECTOR_SIZE
+		+ bucket % BUCKETS_PER_BLOCK * sizeof (uint32_t);
+}
+
+/* Reads and writes the 32-bit link at byte offset OFS of DIR. */
+static uint32_t
+read_link (const struct dir *dir, off_t ofs) {
+	uint32_t link = 0;
+
+	inode_read_at (dir->inode, &link, sizeof link, ofs);
+	return link;
+}
+
+static void
+write_link (struct dir *dir, off_t ofs, uint32_t link) {
+	inode_write_at (dir->inode, &link, sizeof link, ofs);
+}
+
+/* Doubles the number of buckets in DIR, whose header is *H, once the
+ * chains average more than two entries.  The new bucket blocks go at
+ * the end of the directory and every entry in use is re-chained; free
+ * entries are left alone.  Gives up quietly, leaving the index as it
+ * was, if the directory cannot grow or memory runs out. */
+static void
+maybe_grow_index (struct dir *dir, struct dir_header *h) {
+	struct dir_header new = *h;
+	uint32_t *heads = NULL;
+	struct dir_entry *block = NULL;
+	size_t blk_cnt, blk, i;
+
+	if (h->entry_cnt <= 2 * h->bucket_cnt
+			|| h->bucket_cnt * 2 / BUCKETS_PER_BLOCK > BUCKET_BLK_MAX)
+		return;
+
+	new.bucket_cnt = h->bucket_cnt * 2;
+	new.bucket_blk_cnt = new.bucket_cnt / BUCKETS_PER_BLOCK;
+	heads = calloc (new.bucket_cnt, sizeof *heads);
+	block = malloc (DISK_SECTOR_SIZE);
+	if (heads == NULL || block == NULL)
+		goto done;
+
+	/* Claim blocks for the new heads past the end of the directory. */
+	blk_cnt = DIV_ROUND_UP (inode_length (dir->inode), DISK_SECTOR_SIZE);
+	for (i = h->bucket_blk_cnt; i < new.bucket_blk_cnt; i++)
+		new.bucket_blk[i] = blk_cnt + (i - h->bucket_blk_cnt);
+	if (inode_write_at (dir->inode, heads + h->bucket_blk_cnt * BUCKETS_PER_BLOCK,
+				(new.bucket_blk_cnt - h->bucket_blk_cnt) * DISK_SECTOR_SIZE,
+				blk_cnt * DISK_SECTOR_SIZE)
+			!= (off_t) ((new.bucket_blk_cnt - h->bucket_blk_cnt)
+				* DISK_SECTOR_SIZE))
+		goto done;
+
+	/* Re-chain every entry in use, a block at a time. */
+	for (blk = 1; blk < blk_cnt; blk++) {
+		off_t n;
+
+		if (is_bucket_block (h, blk))
+			continue;
+		n = inode_read_at (dir->inode, block, DISK_SECTOR_SIZE,
+				blk * DISK_SECTOR_SIZE);
+		for (i = 0; i < ENTRIES_PER_BLOCK
+				&& (i + 1) * sizeof *block <= (size_t) n; i++)
+			if (block[i].in_use) {
+				uint32_t bucket = hash_string (block[i].name)
+					& (new.bucket_cnt - 1);
+				block[i].next = heads[bucket];
+				heads[bucket] = blk * DISK_SECTOR_SIZE + i * sizeof *block;
+			}
+		inode_write_at (dir->inode, block, n, blk * DISK_SECTOR_SIZE);
+	}
+
+	for (i = 0; i < new.bucket_blk_cnt; i++)
+		inode_write_at (dir->inode, heads + i * BUCKETS_PER_BLOCK,
+				DISK_SECTOR_SIZE, new.bucket_blk[i] * DISK_SECTOR_SIZE);
+	*h = new;
+
+done:
+	free (block);
+	free (heads);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
 dir_create (disk_sector_t sector, size_t entry_cnt) {
-	return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
+	size_t blocks = 2 + DIV_ROUND_UP (entry_cnt, ENTRIES_PER_BLOCK);
+
+	ASSERT (sizeof (struct dir_header) == DISK_SECTOR_SIZE);
+	return inode_create (sector, blocks * DISK_SECTOR_SIZE);
 }
 
 /* Opens and returns the directory for the given INODE, of which
@@ -71,29 +228,38 @@ dir_get_inode (struct dir *dir) {
 	return dir->inode;
 }
 
-/* Searches DIR for a file with the given NAME.
+/* Searches DIR, whose header is *H, for a file with the given NAME.
  * If successful, returns true, sets *EP to the directory entry
- * if EP is non-null, and sets *OFSP to the byte offset of the
- * directory entry if OFSP is non-null.
- * otherwise, returns false and ignores EP and OFSP. */
+ * if EP is non-null, sets *OFSP to the byte offset of the
+ * directory entry if OFSP is non-null, and sets *PREVP to the offset
+ * of the entry before it on its chain (0 if it is first) if PREVP is
+ * non-null.
+ * otherwise, returns false and ignores EP, OFSP and PREVP. */
 static bool
-lookup (const struct dir *dir, const char *name,
-		struct dir_entry *ep, off_t *ofsp) {
+lookup (const struct dir *dir, const struct dir_header *h, const char *name,
+		struct dir_entry *ep, off_t *ofsp, off_t *prevp) {
 	struct dir_entry e;
-	size_t ofs;
+	off_t ofs, prev = 0;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
+	lookup_cnt++;
+	for (ofs = read_link (dir, bucket_ofs (h, name)); ofs != 0; ofs = e.next) {
+		probe_cnt++;
+		if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+			break;
 		if (e.in_use && !strcmp (name, e.name)) {
 			if (ep != NULL)
 				*ep = e;
 			if (ofsp != NULL)
 				*ofsp = ofs;
+			if (prevp != NULL)
+				*prevp = prev;
 			return true;
 		}
+		prev = ofs;
+	}
 	return false;
 }
 
@@ -104,15 +270,19 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
+	struct dir_header h;
 	struct dir_entry e;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
+	inode_dir_lock (dir->inode);
+	read_header (dir, &h);
+	if (lookup (dir, &h, name, &e, NULL, NULL))
 		*inode = inode_open (e.inode_sector);
 	else
 		*inode = NULL;
+	inode_dir_unlock (dir->inode);
 
 	return *inode != NULL;
 }
@@ -125,8 +295,9 @@ dir_lookup (const struct dir *dir, const char *name,
  * error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+	struct dir_header h;
 	struct dir_entry e;
-	off_t ofs;
+	off_t ofs, head_ofs;
 	bool success = false;
 
 	ASSERT (dir != NULL);
@@ -137,28 +308,45 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 		return false;
 
 	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
+	inode_dir_lock (dir->inode);
+	read_header (dir, &h);
+	if (lookup (dir, &h, name, NULL, NULL, NULL))
 		goto done;
 
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
-			break;
+	/* Set OFS to a free slot: a freed entry if there is one, otherwise
+	 * the next never-used one, skipping bucket blocks and the slack at
+	 * the end of each block.  A slot past the end of the directory
+	 * grows it, or fails if it cannot grow. */
+	if (h.free_head != 0) {
+		ofs = h.free_head;
+		h.free_head = read_link (dir, ofs + offsetof (struct dir_entry, next));
+	} else {
+		ofs = h.next_unused;
+		while (is_bucket_block (&h, ofs / DISK_SECTOR_SIZE)
+				|| ofs % DISK_SECTOR_SIZE
+				>= (off_t) (ENTRIES_PER_BLOCK * sizeof e))
+			ofs = ROUND_UP (ofs + 1, DISK_SECTOR_SIZE);
+		h.next_unused = ofs + sizeof e;
+	}
 
-	/* Write slot. */
+	/* Write slot at the head of its chain. */
+	head_ofs = bucket_ofs (&h, name);
+	memset (&e, 0, sizeof e);
 	e.in_use = true;
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
+	e.next = read_link (dir, head_ofs);
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	if (!success)
+		goto done;
+	write_link (dir, head_ofs, ofs);
+
+	h.entry_cnt++;
+	maybe_grow_index (dir, &h);
+	write_header (dir, &h);
 
 done:
+	inode_dir_unlock (dir->inode);
 	return success;
 }
 
@@ -167,16 +355,19 @@ done:
  * which occurs only if there is no file with the given NAME. */
 bool
 dir_remove (struct dir *dir, const char *name) {
+	struct dir_header h;
 	struct dir_entry e;
 	struct inode *inode = NULL;
 	bool success = false;
-	off_t ofs;
+	off_t ofs, prev;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
-	if (!lookup (dir, name, &e, &ofs))
+	inode_dir_lock (dir->inode);
+	read_header (dir, &h);
+	if (!lookup (dir, &h, name, &e, &ofs, &prev))
 		goto done;
 
 	/* Open inode. */
@@ -184,16 +375,25 @@ dir_remove (struct dir *dir, const char *name) {
 	if (inode == NULL)
 		goto done;
 
-	/* Erase directory entry. */
+	/* Unlink the entry from its chain and put it on the free list. */
+	if (prev != 0)
+		write_link (dir, prev + offsetof (struct dir_entry, next), e.next);
+	else
+		write_link (dir, bucket_ofs (&h, name), e.next);
 	e.in_use = false;
+	e.next = h.free_head;
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
+	h.free_head = ofs;
+	h.entry_cnt--;
+	write_header (dir, &h);
 
 	/* Remove inode. */
 	inode_remove (inode);
 	success = true;
 
 done:
+	inode_dir_unlock (dir->inode);
 	inode_close (inode);
 	return success;
 }
@@ -203,14 +403,43 @@ done:
  * contains no more entries. */
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
+	struct dir_header h;
 	struct dir_entry e;
+	bool found = false;
+
+	inode_dir_lock (dir->inode);
+	read_header (dir, &h);
+	while (!found) {
+		size_t blk = dir->pos / DISK_SECTOR_SIZE;
+
+		/* Skip the header, bucket blocks and the end of each block. */
+		if (blk == 0 || is_bucket_block (&h, blk)
+				|| dir->pos % DISK_SECTOR_SIZE
+				>= (off_t) (ENTRIES_PER_BLOCK * sizeof e)) {
+			dir->pos = (blk + 1) * DISK_SECTOR_SIZE;
+			continue;
+		}
 
-	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
+		if (inode_read_at (dir->inode, &e, sizeof e, dir->pos) != sizeof e)
+			break;
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
 		}
 	}
-	return false;
+	inode_dir_unlock (dir->inode);
+	return found;
+}
+
+/* Prints the average number of entries a name lookup examined. */
+void
+dir_print_stats (void) {
+	unsigned long long avg;
+
+	if (lookup_cnt == 0)
+		return;
+	avg = probe_cnt * 100 / lookup_cnt;
+	printf ("Directory: %llu lookups, %llu.%02llu entries examined per lookup\n",
+			lookup_cnt, avg / 100, avg % 100);
 }
@@ -1,8 +1,11 @@
 #include "filesys/fat.h"
 #include "devices/disk.h"
 #include "filesys/filesys.h"
+#include <bitmap.h>
+#include "devices/timer.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -24,12 +27,40 @@ struct fat_fs {
 	disk_sector_t data_start;
 	cluster_t last_clst;
 	struct lock write_lock;
+	struct bitmap *free_map;        /* In-memory index of used clusters. */
+	cluster_t alloc_hint;           /* Next-fit starting point. */
+	struct bitmap *loaded;          /* FAT sectors read in from disk. */
+	struct bitmap *dirty;           /* FAT sectors changed since written. */
+	struct lock flush_lock;         /* Serializes fat_flush(). */
 };
 
+/* Number of FAT entries held by one FAT sector. */
+#define ENTRIES_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
+/* How often the background flusher writes dirty FAT sectors back. */
+#define FAT_FLUSH_INTERVAL (5 * TIMER_FREQ)
+
+/* Length of the free run a new chain tries to start in, so that
+ * later extensions can take the neighbouring cluster. */
+#define FAT_RUN_HINT 8
+
 static struct fat_fs *fat_fs;
 
+/* Allocation statistics. */
+static unsigned long long alloc_clst_cnt;  /* Clusters handed out. */
+static unsigned long long alloc_run_cnt;   /* Physically contiguous runs. */
+
+/* FAT I/O statistics. */
+static unsigned long long fat_read_cnt;    /* FAT sectors read. */
+static unsigned long long fat_write_cnt;   /* FAT sectors written. */
+static unsigned long long fat_run_cnt;     /* Runs they were written in. */
+
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_create_maps (bool loaded);
+static void fat_load_sector (size_t sec);
+static void fat_flush (void);
+static void fat_flushd (void *aux);
 
 void
 fat_init (void) {
@@ -51,35 +82,20 @@ fat_init (void) {
 	fat_fs_init ();
 }
 
+/* Sets up the in-memory FAT.  Its sectors are read from disk only
+ * when first touched, so mounting does not scale with disk size. */
 void
 fat_open (void) {
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
+	fat_create_maps (false);
 
-	// Load FAT directly from the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i,
-			           buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
-		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
-			free (bounce);
-		}
-	}
+	thread_create ("fat_flushd", PRI_DEFAULT, fat_flushd, NULL);
 }
 
+/* Writes back the boot sector and every dirty FAT sector. */
 void
 fat_close (void) {
 	// Write FAT boot sector
@@ -90,27 +106,7 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
-	}
+	fat_flush ();
 }
 
 void
@@ -124,8 +120,10 @@ fat_create (void) {
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
 
-	// Set up ROOT_DIR_CLST
-	fat_put (ROOT_DIR_CLUSTER, EOChain);
+	// Set up ROOT_DIR_CLST; the whole table is new and must be written.
+	fat_fs->fat[ROOT_DIR_CLUSTER] = EOChain;
+	fat_create_maps (true);
+	bitmap_set_all (fat_fs->dirty, true);
 
 	// Fill up ROOT_DIR_CLUSTER region with 0
 	uint8_t *buf = calloc (1, DISK_SECTOR_SIZE);
@@ -152,42 +150,302 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	/* Clusters are numbered from 1, and cluster 0 stands for "no
+	 * cluster", so the table has one entry per data sector plus one. */
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors - fat_fs->data_start)
+	                     / SECTORS_PER_CLUSTER + 1;
+	fat_fs->last_clst = fat_fs->fat_length - 1;
+	fat_fs->alloc_hint = ROOT_DIR_CLUSTER + 1;
+	lock_init (&fat_fs->write_lock);
+	lock_init (&fat_fs->flush_lock);
+}
+
+/* (Re)creates the free-cluster index and the per-sector loaded and
+ * dirty maps.  If LOADED, the table in memory is complete and the
+ * free-cluster index is built from it; otherwise every cluster counts
+ * as used until the FAT sector describing it is loaded. */
+static void
+fat_create_maps (bool loaded) {
+	cluster_t clst;
+
+	bitmap_destroy (fat_fs->free_map);
+	bitmap_destroy (fat_fs->loaded);
+	bitmap_destroy (fat_fs->dirty);
+	fat_fs->free_map = bitmap_create (fat_fs->fat_length);
+	fat_fs->loaded = bitmap_create (fat_fs->bs.fat_sectors);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->free_map == NULL || fat_fs->loaded == NULL
+	    || fat_fs->dirty == NULL)
+		PANIC ("FAT map creation failed");
+
+	bitmap_set_all (fat_fs->loaded, loaded);
+	bitmap_set_all (fat_fs->free_map, !loaded);
+	bitmap_mark (fat_fs->free_map, 0);
+	if (loaded)
+		for (clst = 1; clst < fat_fs->fat_length; clst++)
+			if (fat_fs->fat[clst] != 0)
+				bitmap_mark (fat_fs->free_map, clst);
+}
+
+/* Returns the number of FAT entries stored in FAT sector SEC. */
+static size_t
+fat_sector_entries (size_t sec) {
+	size_t first = sec * ENTRIES_PER_SECTOR;
+	size_t left = fat_fs->fat_length - first;
+	return left < ENTRIES_PER_SECTOR ? left : ENTRIES_PER_SECTOR;
+}
+
+/* Reads FAT sector SEC into the table and records which of its
+ * clusters are free.  Must be called with the FAT lock held. */
+static void
+fat_load_sector (size_t sec) {
+	size_t first = sec * ENTRIES_PER_SECTOR;
+	size_t cnt = fat_sector_entries (sec);
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&fat_fs->write_lock));
+	ASSERT (!bitmap_test (fat_fs->loaded, sec));
+
+	if (cnt == ENTRIES_PER_SECTOR)
+		disk_read (filesys_disk, fat_fs->bs.fat_start + sec,
+		           fat_fs->fat + first);
+	else {
+		uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
+		if (bounce == NULL)
+			PANIC ("FAT load failed");
+		disk_read (filesys_disk, fat_fs->bs.fat_start + sec, bounce);
+		memcpy (fat_fs->fat + first, bounce, cnt * sizeof (cluster_t));
+		free (bounce);
+	}
+	fat_read_cnt++;
+
+	for (i = first == 0 ? 1 : first; i < first + cnt; i++)
+		bitmap_set (fat_fs->free_map, i, fat_fs->fat[i] != 0);
+	bitmap_mark (fat_fs->loaded, sec);
+}
+
+/* Makes sure the FAT entry for CLST is in memory.
+ * Must be called with the FAT lock held. */
+static void
+fat_ensure_loaded (cluster_t clst) {
+	size_t sec = clst / ENTRIES_PER_SECTOR;
+
+	if (!bitmap_test (fat_fs->loaded, sec))
+		fat_load_sector (sec);
+}
+
+/* Sets the FAT entry for CLST to VAL and marks its sector dirty.
+ * Must be called with the FAT lock held. */
+static void
+fat_set_entry (cluster_t clst, cluster_t val) {
+	fat_ensure_loaded (clst);
+	fat_fs->fat[clst] = val;
+	bitmap_set (fat_fs->free_map, clst, val != 0);
+	bitmap_mark (fat_fs->dirty, clst / ENTRIES_PER_SECTOR);
+}
+
+/* Writes every dirty FAT sector back to disk, a run of adjacent
+ * sectors at a time.  Each run is copied out under the FAT lock and
+ * written without it, so allocation is not held up by the disk; a
+ * sector changed meanwhile is simply dirty again. */
+static void
+fat_flush (void) {
+	uint8_t *buf = malloc (DISK_SECTOR_SIZE);
+	size_t sec = 0;
+
+	if (buf == NULL)
+		PANIC ("FAT flush failed");
+
+	lock_acquire (&fat_fs->flush_lock);
+	for (;;) {
+		size_t start;
+
+		lock_acquire (&fat_fs->write_lock);
+		start = bitmap_scan (fat_fs->dirty, sec, 1, true);
+		lock_release (&fat_fs->write_lock);
+		if (start == BITMAP_ERROR)
+			break;
+
+		for (sec = start; sec < fat_fs->bs.fat_sectors; sec++) {
+			lock_acquire (&fat_fs->write_lock);
+			if (!bitmap_test (fat_fs->dirty, sec)) {
+				lock_release (&fat_fs->write_lock);
+				break;
+			}
+			memset (buf, 0, DISK_SECTOR_SIZE);
+			memcpy (buf, fat_fs->fat + sec * ENTRIES_PER_SECTOR,
+			        fat_sector_entries (sec) * sizeof (cluster_t));
+			bitmap_reset (fat_fs->dirty, sec);
+			lock_release (&fat_fs->write_lock);
+
+			disk_write (filesys_disk, fat_fs->bs.fat_start + sec, buf);
+			fat_write_cnt++;
+		}
+		fat_run_cnt++;
+	}
+	lock_release (&fat_fs->flush_lock);
+	free (buf);
+}
+
+/* Background thread that periodically writes dirty FAT sectors back,
+ * so that a crash loses at most FAT_FLUSH_INTERVAL of allocations. */
+static void
+fat_flushd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (FAT_FLUSH_INTERVAL);
+		fat_flush ();
+	}
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Scans the free map for CNT free clusters in a row, starting at the
+ * next-fit hint and wrapping around once.  Only clusters whose FAT
+ * sector has been loaded can be found free, so another sector is
+ * loaded each time the loaded part comes up short.  Returns the first
+ * cluster, or BITMAP_ERROR.  Must be called with the FAT lock held. */
+static size_t
+fat_scan_free (size_t cnt) {
+	for (;;) {
+		size_t idx, sec;
+
+		idx = bitmap_scan (fat_fs->free_map, fat_fs->alloc_hint, cnt, false);
+		if (idx == BITMAP_ERROR)
+			idx = bitmap_scan (fat_fs->free_map, 1, cnt, false);
+		if (idx != BITMAP_ERROR)
+			return idx;
+
+		sec = bitmap_scan (fat_fs->loaded,
+		                   fat_fs->alloc_hint / ENTRIES_PER_SECTOR, 1, false);
+		if (sec == BITMAP_ERROR)
+			sec = bitmap_scan (fat_fs->loaded, 0, 1, false);
+		if (sec == BITMAP_ERROR)
+			return BITMAP_ERROR;
+		fat_load_sector (sec);
+	}
+}
+
+/* Picks a free cluster to follow CLST (0 for a new chain) and marks it
+ * used.  The cluster right after CLST is preferred; otherwise a new
+ * run is started, ideally in a gap large enough to grow into.
+ * Must be called with the FAT lock held. */
+static cluster_t
+fat_alloc_cluster (cluster_t clst) {
+	size_t idx = BITMAP_ERROR;
+
+	if (clst != 0 && clst + 1 < fat_fs->fat_length)
+		fat_ensure_loaded (clst + 1);
+	if (clst != 0 && clst + 1 < fat_fs->fat_length
+	    && !bitmap_test (fat_fs->free_map, clst + 1))
+		idx = clst + 1;
+	else {
+		idx = fat_scan_free (FAT_RUN_HINT);
+		if (idx == BITMAP_ERROR)
+			idx = fat_scan_free (1);
+		if (idx == BITMAP_ERROR)
+			return 0;
+		alloc_run_cnt++;
+	}
+
+	bitmap_mark (fat_fs->free_map, idx);
+	fat_fs->alloc_hint = idx + 1 < fat_fs->fat_length ? idx + 1 : 1;
+	alloc_clst_cnt++;
+	return idx;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t new_clst;
+
+	ASSERT (clst < fat_fs->fat_length);
+
+	lock_acquire (&fat_fs->write_lock);
+	new_clst = fat_alloc_cluster (clst);
+	if (new_clst != 0) {
+		fat_set_entry (new_clst, EOChain);
+		if (clst != 0)
+			fat_set_entry (clst, new_clst);
+	}
+	lock_release (&fat_fs->write_lock);
+	return new_clst;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set_entry (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next;
+
+		ASSERT (clst < fat_fs->fat_length);
+		fat_ensure_loaded (clst);
+		next = fat_fs->fat[clst];
+		fat_set_entry (clst, 0);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+
+	lock_acquire (&fat_fs->write_lock);
+	fat_set_entry (clst, val);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+
+	/* A sector, once loaded, stays loaded. */
+	if (!bitmap_test (fat_fs->loaded, clst / ENTRIES_PER_SECTOR)) {
+		lock_acquire (&fat_fs->write_lock);
+		fat_ensure_loaded (clst);
+		lock_release (&fat_fs->write_lock);
+	}
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Converts a sector number in the data area back to its cluster #. */
+cluster_t
+sector_to_cluster (disk_sector_t sector) {
+	ASSERT (sector >= fat_fs->data_start);
+	return (sector - fat_fs->data_start) / SECTORS_PER_CLUSTER + 1;
+}
+
+/* Prints FAT I/O and how contiguously clusters have been handed out. */
+void
+fat_print_stats (void) {
+	unsigned long long avg;
+
+	if (fat_fs == NULL)
+		return;
+	printf ("FAT: %llu sectors read, %llu sectors written in %llu runs\n",
+	        fat_read_cnt, fat_write_cnt, fat_run_cnt);
+	if (alloc_run_cnt == 0)
+		return;
+	avg = alloc_clst_cnt * 100 / alloc_run_cnt;
+	printf ("FAT: %llu clusters allocated in %llu runs, "
+	        "average run length %llu.%02llu\n",
+	        alloc_clst_cnt, alloc_run_cnt, avg / 100, avg % 100);
 }
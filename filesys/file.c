@@ -2,9 +2,13 @@
 
 #include <debug.h>
 
+#include "devices/disk.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
 
+/** #Project 4: Read-ahead 최대 창 크기 (섹터 수), 버퍼 캐시의 1/4 */
+#define RA_WINDOW_MAX 16
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
@@ -63,8 +67,31 @@ struct inode *file_get_inode(struct file *file) {
  * which may be less than SIZE if end of file is reached.
  * Advances FILE's position by the number of bytes read. */
 off_t file_read(struct file *file, void *buffer, off_t size) {
+    /** #Project 4: Read-ahead - 순차 읽기면 창을 두 배로 키우고, 아니면 접음 */
+    if (file->pos == file->ra_next) {
+        file->ra_window = file->ra_window == 0 ? 1 : file->ra_window * 2;
+        if (file->ra_window > RA_WINDOW_MAX)
+            file->ra_window = RA_WINDOW_MAX;
+    } else {
+        file->ra_window = 0;
+        file->ra_end = file->pos;
+    }
+
     off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
     file->pos += bytes_read;
+    file->ra_next = file->pos;
+
+    /** #Project 4: Read-ahead - 창 안에서 아직 요청하지 않은 섹터만 미리 읽기 요청 */
+    if (file->ra_window > 0) {
+        off_t limit = file->pos + file->ra_window * DISK_SECTOR_SIZE;
+
+        if (file->ra_end < file->pos)
+            file->ra_end = file->pos;
+        if (file->ra_end < limit) {
+            inode_readahead(file->inode, file->ra_end, limit - file->ra_end);
+            file->ra_end = limit;
+        }
+    }
     return bytes_read;
 }
 
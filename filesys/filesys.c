@@ -9,6 +9,7 @@
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
+#include "filesys/page_cache.h"
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
@@ -22,6 +23,7 @@ void filesys_init(bool format) {
     if (filesys_disk == NULL)
         PANIC("hd0:1 (hdb) not present, file system initialization failed");
 
+    page_cache_init();
     inode_init();
 
 #ifdef EFILESYS
@@ -51,6 +53,9 @@ void filesys_done(void) {
 #else
     free_map_close();
 #endif
+
+    /** 버퍼 캐시에 남은 dirty 섹터를 디스크에 반영 */
+    page_cache_flush();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -60,9 +65,19 @@ void filesys_done(void) {
 bool filesys_create(const char *name, off_t initial_size) {
     disk_sector_t inode_sector = 0;
     struct dir *dir = dir_open_root();
+#ifdef EFILESYS
+    /** inode 섹터도 FAT 클러스터 하나로 할당 */
+    cluster_t inode_clst = dir != NULL ? fat_create_chain(0) : 0;
+    if (inode_clst != 0)
+        inode_sector = cluster_to_sector(inode_clst);
+    bool success = (inode_clst != 0 && inode_create(inode_sector, initial_size) && dir_add(dir, name, inode_sector));
+    if (!success && inode_clst != 0)
+        fat_remove_chain(inode_clst, 0);
+#else
     bool success = (dir != NULL && free_map_allocate(1, &inode_sector) && inode_create(inode_sector, initial_size) && dir_add(dir, name, inode_sector));
     if (!success && inode_sector != 0)
         free_map_release(inode_sector, 1);
+#endif
     dir_close(dir);
 
     return success;
@@ -103,6 +118,8 @@ static void do_format(void) {
 #ifdef EFILESYS
     /* Create FAT and save it to the disk. */
     fat_create();
+    if (!dir_create(ROOT_DIR_SECTOR, 16))
+        PANIC("root directory creation failed");
     fat_close();
 #else
     free_map_create();
@@ -1,22 +1,41 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
+#include <intrinsic.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/fat.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/page_cache.h"
+#include <stdio.h>
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Maximum number of holes an on-disk inode can record. */
+#define HOLE_MAX 61
+
+/* A range of data sectors, by index within the file, that have been
+ * allocated but never written.  They read as zeros without touching
+ * the disk, and are zeroed in the cache when first partially written. */
+struct inode_hole {
+	uint32_t start;                     /* First sector index. */
+	uint32_t end;                       /* One past the last. */
+};
+
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
+	disk_sector_t start;                /* First data sector (first data
+	                                       cluster under EFILESYS). */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	uint32_t hole_cnt;                  /* Number of HOLES in use. */
+	struct inode_hole holes[HOLE_MAX];  /* Never-written sectors. */
+	uint32_t unused[2];                 /* Not used. */
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -28,35 +47,287 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem elem;              /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
+	bool loaded;                        /* DATA has been read from disk. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct rwlock rw;                   /* Guards DATA and the file data. */
+	struct lock dir_lock;               /* Held across directory updates. */
+#ifdef EFILESYS
+	struct lock chain_lock;             /* Protects the fields below. */
+	size_t cursor_idx;                  /* Index of the last cluster found, */
+	cluster_t cursor_clst;              /* ...and the cluster itself. */
+	cluster_t *skip;                    /* Every SKIP_STRIDE'th cluster, */
+	size_t skip_cnt;                    /* ...0 where not yet known. */
+#endif
 };
 
+#ifdef EFILESYS
+/* Distance, in clusters, between entries of an inode's skip list. */
+#define SKIP_STRIDE 64
+
+/* Chain-walk statistics. */
+static unsigned long long chain_lookup_cnt;  /* byte_to_sector() calls. */
+static unsigned long long chain_step_cnt;    /* fat_get() calls they made. */
+
+/* Allocates a chain of SECTORS clusters and stores its first cluster
+ * in *START, or 0 if SECTORS is 0.
+ * Returns true if successful, false if the disk is full. */
+static bool
+inode_allocate (size_t sectors, disk_sector_t *start) {
+	cluster_t head = 0, tail = 0;
+
+	for (; sectors > 0; sectors--) {
+		tail = fat_create_chain (tail);
+		if (tail == 0) {
+			if (head != 0)
+				fat_remove_chain (head, 0);
+			return false;
+		}
+		if (head == 0)
+			head = tail;
+	}
+	*start = head;
+	return true;
+}
+
+/* Remembers that CLST is the IDX'th cluster of INODE, in the skip
+ * list if IDX falls on a stride boundary and in the cursor. */
+static void
+inode_chain_note (struct inode *inode, size_t idx, cluster_t clst) {
+	if (idx % SKIP_STRIDE == 0) {
+		size_t slot = idx / SKIP_STRIDE;
+
+		if (slot >= inode->skip_cnt) {
+			size_t cnt = bytes_to_sectors (inode->data.length) / SKIP_STRIDE + 1;
+			cluster_t *skip;
+
+			if (cnt <= slot)
+				cnt = slot + 1;
+			skip = realloc (inode->skip, cnt * sizeof *skip);
+			if (skip != NULL) {
+				memset (skip + inode->skip_cnt, 0,
+						(cnt - inode->skip_cnt) * sizeof *skip);
+				inode->skip = skip;
+				inode->skip_cnt = cnt;
+			}
+		}
+		if (slot < inode->skip_cnt)
+			inode->skip[slot] = clst;
+	}
+	inode->cursor_idx = idx;
+	inode->cursor_clst = clst;
+}
+
+/* Returns the IDX'th cluster of INODE's data.  The walk resumes from
+ * whichever is closer below IDX: the cursor left by the previous
+ * lookup or the nearest known skip-list entry, so sequential access
+ * costs one step per cluster and a random seek at most SKIP_STRIDE
+ * steps once the chain has been walked through once. */
+static cluster_t
+inode_chain_lookup (struct inode *inode, size_t idx) {
+	size_t cur_idx = 0, slot;
+	cluster_t clst = inode->data.start;
+
+	lock_acquire (&inode->chain_lock);
+	for (slot = idx / SKIP_STRIDE; slot > 0; slot--)
+		if (slot < inode->skip_cnt && inode->skip[slot] != 0) {
+			cur_idx = slot * SKIP_STRIDE;
+			clst = inode->skip[slot];
+			break;
+		}
+	if (inode->cursor_clst != 0 && inode->cursor_idx <= idx
+			&& inode->cursor_idx > cur_idx) {
+		cur_idx = inode->cursor_idx;
+		clst = inode->cursor_clst;
+	}
+
+	chain_lookup_cnt++;
+	while (cur_idx < idx) {
+		clst = fat_get (clst);
+		chain_step_cnt++;
+		if (++cur_idx % SKIP_STRIDE == 0)
+			inode_chain_note (inode, cur_idx, clst);
+	}
+	inode_chain_note (inode, idx, clst);
+	lock_release (&inode->chain_lock);
+	return clst;
+}
+
+#else
+/* Allocates SECTORS consecutive sectors and stores the first in
+ * *START.  Returns true if successful, false otherwise. */
+static bool
+inode_allocate (size_t sectors, disk_sector_t *start) {
+	return free_map_allocate (sectors, start);
+}
+#endif
+
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
  * POS. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
 	if (pos < inode->data.length)
+#ifdef EFILESYS
+		return cluster_to_sector (inode_chain_lookup (inode,
+					pos / DISK_SECTOR_SIZE));
+#else
 		return inode->data.start + pos / DISK_SECTOR_SIZE;
+#endif
 	else
 		return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Writes INODE's on-disk inode back through the buffer cache. */
+static void
+inode_save (struct inode *inode) {
+	page_cache_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+}
+
+/* Returns the hole of INODE that contains data sector index IDX, or a
+ * null pointer if that sector holds written data. */
+static struct inode_hole *
+inode_find_hole (struct inode *inode, size_t idx) {
+	uint32_t i;
+
+	for (i = 0; i < inode->data.hole_cnt; i++) {
+		struct inode_hole *h = &inode->data.holes[i];
+		if (idx >= h->start && idx < h->end)
+			return h;
+	}
+	return NULL;
+}
+
+/* Writes zeros to data sectors START through END - 1 of INODE, for a
+ * hole that no longer fits in the hole table. */
+static void
+inode_zero_range (struct inode *inode, size_t start, size_t end) {
+	for (; start < end; start++)
+		page_cache_zero (byte_to_sector (inode, start * DISK_SECTOR_SIZE));
+}
+
+/* Takes data sector index IDX, which has just been written, out of
+ * hole H of INODE.  If splitting H needs a table slot and none is
+ * free, the shorter side is zeroed on disk instead. */
+static void
+inode_fill_hole (struct inode *inode, struct inode_hole *h, size_t idx) {
+	if (h->start == idx)
+		h->start++;
+	else if (h->end == idx + 1)
+		h->end--;
+	else if (inode->data.hole_cnt < HOLE_MAX) {
+		inode->data.holes[inode->data.hole_cnt++] =
+			(struct inode_hole) { idx + 1, h->end };
+		h->end = idx;
+	} else if (idx - h->start < h->end - idx - 1) {
+		inode_zero_range (inode, h->start, idx);
+		h->start = idx + 1;
+	} else {
+		inode_zero_range (inode, idx + 1, h->end);
+		h->end = idx;
+	}
+
+	if (h->start == h->end)
+		*h = inode->data.holes[--inode->data.hole_cnt];
+	inode_save (inode);
+}
+
+#ifdef EFILESYS
+/* Records data sectors START through END - 1 of INODE as a hole,
+ * merging it into the hole that ends at START if there is one. */
+static void
+inode_add_hole (struct inode *inode, size_t start, size_t end) {
+	uint32_t i;
+
+	if (start == end)
+		return;
+	for (i = 0; i < inode->data.hole_cnt; i++)
+		if (inode->data.holes[i].end == start) {
+			inode->data.holes[i].end = end;
+			break;
+		}
+	if (i == inode->data.hole_cnt) {
+		if (inode->data.hole_cnt < HOLE_MAX)
+			inode->data.holes[inode->data.hole_cnt++] =
+				(struct inode_hole) { start, end };
+		else
+			inode_zero_range (inode, start, end);
+	}
+	inode_save (inode);
+}
+
+/* Grows INODE to LENGTH bytes.  The new sectors are allocated at the
+ * end of the cluster chain but left as a hole, so growing a file
+ * costs no data writes.  Returns true if successful, false if the
+ * disk is full, in which case INODE is unchanged. */
+static bool
+inode_extend (struct inode *inode, off_t length) {
+	size_t have = bytes_to_sectors (inode->data.length);
+	size_t need = bytes_to_sectors (length);
+	cluster_t tail = have > 0 ? inode_chain_lookup (inode, have - 1) : 0;
+	cluster_t first = 0, clst = tail;
+	size_t i;
+
+	for (i = have; i < need; i++) {
+		clst = fat_create_chain (clst);
+		if (clst == 0) {
+			if (first != 0)
+				fat_remove_chain (first, tail);
+			return false;
+		}
+		if (first == 0)
+			first = clst;
+	}
+
+	if (have == 0 && first != 0)
+		inode->data.start = first;
+	inode->data.length = length;
+	inode_add_hole (inode, have, need);
+	inode_save (inode);
+	return true;
+}
+#endif
+
+/* Open inodes, hashed by sector, so that opening a single inode
+ * twice returns the same `struct inode'. */
+static struct hash open_inodes;
+static struct lock open_inodes_lock;    /* Guards OPEN_INODES and the
+                                           OPEN_CNT and LOADED of its
+                                           members. */
+static struct condition inode_loaded;   /* Signaled on OPEN_INODES_LOCK
+                                           when an inode is loaded. */
+
+/* inode_open() statistics. */
+static unsigned long long open_cnt;     /* Calls. */
+static unsigned long long open_cycles;  /* Cycles they took. */
+
+/* Returns a hash value for the inode containing E. */
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct inode *inode = hash_entry (e, struct inode, elem);
+	return hash_bytes (&inode->sector, sizeof inode->sector);
+}
+
+/* Returns true if the inode containing A precedes the one containing B. */
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode, elem)->sector
+		< hash_entry (b, struct inode, elem)->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&open_inodes, inode_hash, inode_less, NULL);
+	lock_init (&open_inodes_lock);
+	cond_init (&inode_loaded);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -80,15 +351,13 @@ inode_create (disk_sector_t sector, off_t length) {
 		size_t sectors = bytes_to_sectors (length);
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
+		if (sectors > 0) {
+			/* The data reads as zeros until written. */
+			disk_inode->hole_cnt = 1;
+			disk_inode->holes[0] = (struct inode_hole) { 0, sectors };
+		}
+		if (inode_allocate (sectors, &disk_inode->start)) {
+			page_cache_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 			success = true; 
 		} 
 		free (disk_inode);
@@ -101,39 +370,71 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	uint64_t start = rdtsc ();
+	struct inode key;
+	struct hash_elem *e;
 	struct inode *inode;
 
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	lock_acquire (&open_inodes_lock);
+	open_cnt++;
+
+	/* Check whether this inode is already open.  If another thread is
+	 * still reading it in, wait for that instead of reading it twice. */
+	key.sector = sector;
+	e = hash_find (&open_inodes, &key.elem);
+	if (e != NULL) {
+		inode = hash_entry (e, struct inode, elem);
+		inode->open_cnt++;
+		while (!inode->loaded)
+			cond_wait (&inode_loaded, &open_inodes_lock);
+		goto done;
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
 	if (inode == NULL)
-		return NULL;
+		goto done;
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize, and make the inode visible only once it can be found
+	 * by its sector.  The disk read happens without OPEN_INODES_LOCK;
+	 * openers of the same sector wait for LOADED meanwhile. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
+	inode->loaded = false;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	hash_insert (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
+
+	page_cache_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	rwlock_init (&inode->rw);
+	lock_init (&inode->dir_lock);
+#ifdef EFILESYS
+	lock_init (&inode->chain_lock);
+	inode->cursor_idx = 0;
+	inode->cursor_clst = 0;
+	inode->skip = NULL;
+	inode->skip_cnt = 0;
+#endif
+
+	lock_acquire (&open_inodes_lock);
+	inode->loaded = true;
+	cond_broadcast (&inode_loaded, &open_inodes_lock);
+
+done:
+	open_cycles += rdtsc () - start;
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -153,19 +454,33 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
-		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
+	lock_acquire (&open_inodes_lock);
+	if (--inode->open_cnt > 0) {
+		lock_release (&open_inodes_lock);
+		return;
+	}
 
-		free (inode); 
+	/* Remove from the open inodes and release lock. */
+	hash_delete (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
+
+	/* Deallocate blocks if removed. */
+	if (inode->removed) {
+#ifdef EFILESYS
+		fat_remove_chain (sector_to_cluster (inode->sector), 0);
+		if (inode->data.start != 0)
+			fat_remove_chain (inode->data.start, 0);
+#else
+		free_map_release (inode->sector, 1);
+		free_map_release (inode->data.start,
+				bytes_to_sectors (inode->data.length)); 
+#endif
 	}
+
+#ifdef EFILESYS
+	free (inode->skip);
+#endif
+	free (inode); 
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -183,11 +498,10 @@ off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
 
+	rwlock_read_acquire (&inode->rw);
 	while (size > 0) {
-		/* Disk sector to read, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		/* Starting byte offset within sector. */
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
@@ -200,27 +514,20 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		/* Copy the chunk out of the buffer cache, unless the sector was
+		 * never written. */
+		if (inode_find_hole (inode, offset / DISK_SECTOR_SIZE) != NULL)
+			memset (buffer + bytes_read, 0, chunk_size);
+		else
+			page_cache_read (byte_to_sector (inode, offset),
+					buffer + bytes_read, sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+	rwlock_read_release (&inode->rw);
 
 	return bytes_read;
 }
@@ -228,22 +535,37 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * Under EFILESYS, a write past end of file first extends the inode;
+ * any gap before OFFSET is left as a hole. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
+	/* A write to a running executable is refused without making the
+	 * readers wait for the exclusive lock.  Writes may have been
+	 * denied since, so look again once the lock is held. */
 	if (inode->deny_write_cnt)
 		return 0;
+	rwlock_write_acquire (&inode->rw);
+	if (inode->deny_write_cnt) {
+		rwlock_write_release (&inode->rw);
+		return 0;
+	}
+
+#ifdef EFILESYS
+	/* If the disk is full, write what fits in the current length. */
+	if (offset + size > inode_length (inode))
+		inode_extend (inode, offset + size);
+#endif
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
+		size_t idx = offset / DISK_SECTOR_SIZE;
+		struct inode_hole *hole;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
 		off_t inode_left = inode_length (inode) - offset;
@@ -255,34 +577,24 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
-		}
+		/* Copy the chunk into the buffer cache, which reads in the
+		 * rest of the sector first unless the chunk covers all of it.
+		 * A sector in a hole has nothing worth reading, so it is
+		 * zeroed in the cache instead. */
+		hole = inode_find_hole (inode, idx);
+		if (hole != NULL && chunk_size < DISK_SECTOR_SIZE)
+			page_cache_zero (sector_idx);
+		page_cache_write (sector_idx, buffer + bytes_written, sector_ofs,
+				chunk_size);
+		if (hole != NULL)
+			inode_fill_hole (inode, hole, idx);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
+	rwlock_write_release (&inode->rw);
 
 	return bytes_written;
 }
@@ -292,8 +604,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_write_acquire (&inode->rw);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_write_release (&inode->rw);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +615,28 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_write_acquire (&inode->rw);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_write_release (&inode->rw);
+}
+
+/* Prints the average cost of inode_open() and, for FAT-backed inodes,
+ * of mapping a file offset to a sector. */
+void
+inode_print_stats (void) {
+	if (open_cnt != 0)
+		printf ("Inode: %llu opens, %llu cycles per open\n",
+				open_cnt, open_cycles / open_cnt);
+#ifdef EFILESYS
+	if (chain_lookup_cnt != 0) {
+		unsigned long long avg = chain_step_cnt * 100 / chain_lookup_cnt;
+		printf ("Inode: %llu chain lookups, "
+				"%llu.%02llu chain-walk steps per lookup\n",
+				chain_lookup_cnt, avg / 100, avg % 100);
+	}
+#endif
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -311,3 +644,31 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Asks the buffer cache to read ahead the sectors holding the SIZE
+ * bytes of INODE starting at OFFSET, stopping at end of file. */
+void
+inode_readahead (struct inode *inode, off_t offset, off_t size) {
+	off_t end = offset + size;
+
+	rwlock_read_acquire (&inode->rw);
+	if (end > inode_length (inode))
+		end = inode_length (inode);
+	for (offset -= offset % DISK_SECTOR_SIZE; offset < end;
+			offset += DISK_SECTOR_SIZE)
+		if (inode_find_hole (inode, offset / DISK_SECTOR_SIZE) == NULL)
+			page_cache_prefetch (byte_to_sector (inode, offset));
+	rwlock_read_release (&inode->rw);
+}
+
+/* Acquires and releases INODE's directory lock, which a directory
+ * holds across the several reads and writes of one update. */
+void
+inode_dir_lock (struct inode *inode) {
+	lock_acquire (&inode->dir_lock);
+}
+
+void
+inode_dir_unlock (struct inode *inode) {
+	lock_release (&inode->dir_lock);
+}
@@ -1,9 +1,73 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
+#include "filesys/page_cache.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "threads/synch.h"
 #include "vm/vm.h"
+
+/* Sector buffer cache.
+ *
+ * All file system data and metadata goes through a fixed array of
+ * CACHE_SIZE sector buffers.  Writes only mark a buffer dirty; it is
+ * written back when the clock evicts it or when the cache is flushed.
+ * CACHE_LOCK guards the table of buffers but is not held across disk
+ * accesses or copies, so readers of unrelated sectors do not wait for
+ * one another's disk I/O.  A buffer being read in or written back is
+ * busy: lookups of its sector wait on CACHE_COND until it is done, and
+ * the clock passes it by.
+ *
+ * The copy between a buffer and the caller's memory also happens
+ * without CACHE_LOCK, because the caller's memory may be a user page
+ * that is not loaded yet, and loading it reads the file system again.
+ * The buffer is pinned meanwhile so the clock passes it by, and a
+ * buffer claimed for a whole-sector write stays busy until the data is
+ * in, so nobody reads it before then. */
+#define CACHE_SIZE 64
+
+struct cache_entry {
+	disk_sector_t sector;               /* Cached sector, if VALID. */
+	bool valid;                         /* Holds a sector? */
+	bool dirty;                         /* Newer than the disk copy? */
+	bool accessed;                      /* Used since the hand passed? */
+	bool busy;                          /* DATA not ready; wait on
+	                                       CACHE_COND. */
+	int pin_cnt;                        /* # of copies in progress. */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Sector contents. */
+};
+
+static struct cache_entry cache[CACHE_SIZE];
+static struct lock cache_lock;
+static struct condition cache_cond;     /* Signaled on CACHE_LOCK when an
+                                           entry stops being busy or
+                                           pinned. */
+static size_t clock_hand;
+
+/* Statistics. */
+static long long hit_cnt;               /* # of lookups found cached. */
+static long long miss_cnt;              /* # of sectors read in. */
+static long long writeback_cnt;         /* # of dirty sectors written. */
+static long long readahead_cnt;         /* # of sectors read ahead. */
+
+/* Read-ahead.  Readers queue the sectors they expect to need next with
+ * page_cache_prefetch () and carry on; page_cache_kworkerd loads them
+ * into the cache in the background, so the disk works while the reader
+ * is busy with the data it already has. */
+#define RA_QUEUE_SIZE 64
+
+static disk_sector_t ra_queue[RA_QUEUE_SIZE];
+static size_t ra_head, ra_tail;         /* Empty when equal. */
+static struct lock ra_lock;             /* Guards RA_QUEUE. */
+static struct semaphore ra_pending;     /* # of queued sectors. */
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
+static void page_cache_kworkerd (void *aux);
+static struct cache_entry *cache_lookup (disk_sector_t sector);
+static struct cache_entry *cache_fill (disk_sector_t sector, bool need_data);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations page_cache_op = {
@@ -46,5 +110,254 @@ page_cache_destroy (struct page *page) {
 
 /* Worker thread for page cache */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	for (;;) {
+		disk_sector_t sector;
+
+		sema_down (&ra_pending);
+		lock_acquire (&ra_lock);
+		sector = ra_queue[ra_head];
+		ra_head = (ra_head + 1) % RA_QUEUE_SIZE;
+		lock_release (&ra_lock);
+
+		lock_acquire (&cache_lock);
+		if (cache_lookup (sector) == NULL && cache_fill (sector, true) != NULL)
+			readahead_cnt++;
+		lock_release (&cache_lock);
+	}
+}
+
+/* Initializes the buffer cache and starts the read-ahead worker. */
+void
+page_cache_init (void) {
+	lock_init (&cache_lock);
+	cond_init (&cache_cond);
+	lock_init (&ra_lock);
+	sema_init (&ra_pending, 0);
+	page_cache_workerd = thread_create ("page_cache_kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
+}
+
+/* Writes back entry E if it is dirty and neither busy nor pinned,
+ * releasing CACHE_LOCK for the disk access.  Returns true if it did.
+ * E is clean afterward unless a writer dirtied it again meanwhile.
+ * A pinned entry is left alone: its pinner may be copying into it, and
+ * cache_release () would clear the busy flag out from under the write.
+ * CACHE_LOCK must be held. */
+static bool
+cache_writeback (struct cache_entry *e) {
+	if (!e->valid || !e->dirty || e->busy || e->pin_cnt > 0)
+		return false;
+
+	e->busy = true;
+	e->dirty = false;
+	lock_release (&cache_lock);
+	disk_write (filesys_disk, e->sector, e->data);
+	lock_acquire (&cache_lock);
+	e->busy = false;
+	writeback_cnt++;
+	cond_broadcast (&cache_cond, &cache_lock);
+	return true;
+}
+
+/* Returns the entry holding SECTOR, or a null pointer.
+ * CACHE_LOCK must be held. */
+static struct cache_entry *
+cache_lookup (disk_sector_t sector) {
+	size_t i;
+
+	for (i = 0; i < CACHE_SIZE; i++)
+		if (cache[i].valid && cache[i].sector == sector)
+			return &cache[i];
+	return NULL;
+}
+
+/* Picks an entry to reuse with the clock algorithm.  Pinned and busy
+ * entries are passed over.  If the chosen entry is dirty, writes it
+ * back, or if two sweeps find nothing, waits for an entry to be
+ * released; either way returns a null pointer, since the cache may
+ * have changed while CACHE_LOCK was released.  CACHE_LOCK must be
+ * held. */
+static struct cache_entry *
+cache_evict (void) {
+	size_t i;
+
+	for (i = 0; i < 2 * CACHE_SIZE; i++) {
+		struct cache_entry *e = &cache[clock_hand];
+		clock_hand = (clock_hand + 1) % CACHE_SIZE;
+
+		if (!e->valid)
+			return e;
+		if (e->busy || e->pin_cnt > 0)
+			continue;
+		if (e->accessed)
+			e->accessed = false;
+		else if (cache_writeback (e))
+			return NULL;
+		else {
+			e->valid = false;
+			return e;
+		}
+	}
+	cond_wait (&cache_cond, &cache_lock);
+	return NULL;
+}
+
+/* Brings SECTOR, which is not cached, into an entry and returns it,
+ * or returns a null pointer if it had to wait for an entry.  Reads the
+ * sector from disk only if NEED_DATA, releasing CACHE_LOCK meanwhile;
+ * otherwise the entry is left busy for the caller to fill.  CACHE_LOCK
+ * must be held. */
+static struct cache_entry *
+cache_fill (disk_sector_t sector, bool need_data) {
+	struct cache_entry *e = cache_evict ();
+
+	if (e == NULL)
+		return NULL;
+	e->sector = sector;
+	e->valid = true;
+	e->dirty = false;
+	e->accessed = true;
+	e->busy = true;
+	if (need_data) {
+		lock_release (&cache_lock);
+		disk_read (filesys_disk, sector, e->data);
+		lock_acquire (&cache_lock);
+		e->busy = false;
+		cond_broadcast (&cache_cond, &cache_lock);
+	}
+	return e;
+}
+
+/* Returns the entry for SECTOR, loading it if necessary, and pins it.
+ * If the caller is about to overwrite the whole sector, pass false for
+ * NEED_DATA to skip reading it from disk; if that claims a new entry,
+ * the entry is busy until cache_release ().  CACHE_LOCK must be held. */
+static struct cache_entry *
+cache_get (disk_sector_t sector, bool need_data) {
+	struct cache_entry *e;
+
+	for (;;) {
+		e = cache_lookup (sector);
+		if (e != NULL) {
+			if (e->busy) {
+				cond_wait (&cache_cond, &cache_lock);
+				continue;
+			}
+			hit_cnt++;
+			e->accessed = true;
+			break;
+		}
+		e = cache_fill (sector, need_data);
+		if (e != NULL) {
+			if (need_data)
+				miss_cnt++;
+			break;
+		}
+	}
+	e->pin_cnt++;
+	return e;
+}
+
+/* Unpins E, taken with cache_get (), marking it dirty if DIRTY.
+ * Nobody else makes a pinned entry busy, so if E is busy it is the
+ * entry our cache_get () claimed without reading it, and its data is
+ * now in.  CACHE_LOCK must be held. */
+static void
+cache_release (struct cache_entry *e, bool dirty) {
+	ASSERT (e->pin_cnt > 0);
+
+	if (dirty)
+		e->dirty = true;
+	e->busy = false;
+	if (--e->pin_cnt == 0)
+		cond_broadcast (&cache_cond, &cache_lock);
+}
+
+/* Copies SIZE bytes starting at byte OFS of SECTOR into BUFFER. */
+void
+page_cache_read (disk_sector_t sector, void *buffer, int ofs, int size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	e = cache_get (sector, true);
+	lock_release (&cache_lock);
+
+	memcpy (buffer, e->data + ofs, size);
+
+	lock_acquire (&cache_lock);
+	cache_release (e, false);
+	lock_release (&cache_lock);
+}
+
+/* Copies SIZE bytes from BUFFER to byte OFS of SECTOR.  The sector
+ * reaches the disk when it is evicted or the cache is flushed. */
+void
+page_cache_write (disk_sector_t sector, const void *buffer, int ofs,
+		int size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	e = cache_get (sector, size < DISK_SECTOR_SIZE);
+	lock_release (&cache_lock);
+
+	memcpy (e->data + ofs, buffer, size);
+
+	lock_acquire (&cache_lock);
+	cache_release (e, true);
+	lock_release (&cache_lock);
+}
+
+/* Fills SECTOR with zeros in the cache without reading it from disk,
+ * for a sector whose previous contents do not matter. */
+void
+page_cache_zero (disk_sector_t sector) {
+	struct cache_entry *e;
+
+	lock_acquire (&cache_lock);
+	e = cache_get (sector, false);
+	memset (e->data, 0, DISK_SECTOR_SIZE);
+	cache_release (e, true);
+	lock_release (&cache_lock);
+}
+
+/* Asks the read-ahead worker to bring SECTOR into the cache.  Returns
+ * at once; the request is dropped if the queue is full. */
+void
+page_cache_prefetch (disk_sector_t sector) {
+	bool queued = false;
+
+	lock_acquire (&ra_lock);
+	if ((ra_tail + 1) % RA_QUEUE_SIZE != ra_head) {
+		ra_queue[ra_tail] = sector;
+		ra_tail = (ra_tail + 1) % RA_QUEUE_SIZE;
+		queued = true;
+	}
+	lock_release (&ra_lock);
+
+	if (queued)
+		sema_up (&ra_pending);
+}
+
+/* Writes every dirty sector back to disk.  A busy sector is skipped;
+ * it is either being written already or its contents are not in yet. */
+void
+page_cache_flush (void) {
+	size_t i;
+
+	lock_acquire (&cache_lock);
+	for (i = 0; i < CACHE_SIZE; i++)
+		cache_writeback (&cache[i]);
+	lock_release (&cache_lock);
+}
+
+/* Prints buffer cache statistics. */
+void
+page_cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses, %lld writebacks, "
+			"%lld read ahead\n", hit_cnt, miss_cnt, writeback_cnt, readahead_cnt);
 }
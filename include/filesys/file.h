@@ -15,6 +15,11 @@ struct file {
     /** #Project 2: Extend File Descriptor */
     int dup_count;
     /** ---------------------------------- */
+
+    /** #Project 4: Read-ahead */
+    off_t ra_next; /* Position a sequential reader reads next. */
+    off_t ra_end;  /* End of the range already handed to read-ahead. */
+    int ra_window; /* Read-ahead window in sectors, 0 when off. */
 };
 
 /* Opening and closing files. */
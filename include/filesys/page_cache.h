@@ -1,12 +1,22 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include "devices/disk.h"
 
 struct page;
 enum vm_type;
 
+/* Defined before including vm/vm.h, which embeds it in struct page. */
 struct page_cache {};
 
+#include "vm/vm.h"
+
 void page_cache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+
+void page_cache_read (disk_sector_t, void *, int ofs, int size);
+void page_cache_write (disk_sector_t, const void *, int ofs, int size);
+void page_cache_zero (disk_sector_t);
+void page_cache_prefetch (disk_sector_t);
+void page_cache_flush (void);
+void page_cache_print_stats (void);
 #endif
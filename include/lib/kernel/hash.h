@@ -102,7 +102,6 @@ uint64_t hash_int (int);
 uint64_t hash_func (const struct hash_elem *e, void *aux);
 bool less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux);
 void action_func (struct hash_elem *e, void *aux);
-void hash_page_destory(struct hash_elem *e, void *aux);
 
 
 #endif /* lib/kernel/hash.h */
@@ -4,10 +4,24 @@
 #include <debug.h>
 #include <stddef.h>
 
+/* Number of block sizes, smallest first, that each thread caches
+   in its own magazines. */
+#define MAGAZINE_CNT 4
+
+/* A thread's cache of free blocks of one size, chained through
+   the blocks themselves. */
+struct magazine {
+	void *top;                  /* Most recently cached block. */
+	size_t cnt;                 /* Number of blocks cached. */
+};
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_drain_magazines (void);
+size_t malloc_blocks_per_page (size_t);
+long long malloc_lock_acquisitions (void);
 
 #endif /* threads/malloc.h */
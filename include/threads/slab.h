@@ -0,0 +1,29 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* A cache of fixed-size objects of one type. */
+struct slab_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Slot size in bytes. */
+	size_t objs_per_slab;       /* Slots in each slab page. */
+	struct list partial;        /* Slabs with at least one free slot. */
+	struct lock lock;           /* Protects the cache. */
+
+	/* Statistics. */
+	long long alloc_cnt;        /* # of objects handed out. */
+	size_t in_use;              /* # of objects now in use. */
+	size_t peak_in_use;         /* Largest IN_USE so far. */
+	size_t slab_cnt;            /* # of slab pages now held. */
+	size_t peak_slab_cnt;       /* Largest SLAB_CNT so far. */
+};
+
+void slab_cache_init (struct slab_cache *, const char *name, size_t obj_size);
+void *slab_alloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (struct slab_cache *);
+
+#endif /* threads/slab.h */
@@ -1,13 +1,14 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority on top. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,6 +21,7 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct list_elem elem;      /* Element in holder's held_locks. */
 };
 
 void lock_init (struct lock *);
@@ -30,7 +32,7 @@ bool lock_held_by_current_thread (const struct lock *);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority on top. */
 };
 
 void cond_init (struct condition *);
@@ -38,9 +40,51 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
-/** #Priority Scheduling - Synchronization 함수 */
+/** #Priority Scheduling - Synchronization 대기 중인 쓰레드의 우선순위 변경 */
+void sema_update_priority (struct thread *, int priority);
+/** #Priority Scheduling - Synchronization 대기 쓰레드 비교 횟수 */
+long long sema_waiter_compares (void);
 
-bool cmp_sem_priority(const struct list_elem *, const struct list_elem *, void *);
+/** #Project 1: Reader-Writer Lock */
+
+/* Maximum number of different rwlocks one thread can hold shared
+   at once.  Every shared hold must be recorded so that a waiting
+   writer can donate to it, so taking one more panics. */
+#define RW_HOLD_MAX 4
+
+/* Reader-writer lock.  A writer holds GATE for its whole critical
+   section, so readers arriving after a writer queue up behind it
+   on GATE and cannot starve it.
+
+   A thread that holds an rwlock shared may take it shared again,
+   as when a read page-faults back into a read of the same inode.
+   The nested hold skips GATE, since waiting there behind a writer
+   that is waiting for this thread would deadlock.  A thread must
+   not take an rwlock shared while it holds it exclusively, nor
+   exclusively while it holds it shared; both are checked. */
+struct rwlock {
+	struct lock gate;           /* Held by the writer; by readers only briefly. */
+	struct semaphore drain;     /* Writer waits here for readers to leave. */
+	struct thread *drainer;     /* Writer waiting on DRAIN, or NULL. */
+	int readers;                /* Number of threads holding it shared. */
+	struct list holders;        /* rw_hold of each tracked reader. */
+};
+
+/* One shared hold of an rwlock, kept in the reading thread so a
+   waiting writer can donate its priority to the readers. */
+struct rw_hold {
+	struct rwlock *rw;          /* Lock held shared, or NULL if unused. */
+	struct thread *thread;      /* Reading thread. */
+	int depth;                  /* Nested shared acquisitions of RW. */
+	struct list_elem elem;      /* Element in RW's holders. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
 
 /* Optimization barrier.
  *
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/synch.h"
 #ifdef VM
 #include "vm/vm.h"
@@ -94,11 +95,13 @@ typedef int tid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
+ * the run queue (thread.c), or it can be an element in a sleep
+ * wheel slot (thread.c).  It can be used these two ways only
+ * because they are mutually exclusive: only a thread in the
  * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * blocked state is in a sleep wheel slot.  A thread blocked on a
+ * semaphore is in the semaphore's waiter heap through `wait_elem'
+ * instead. */
 typedef struct thread {
     /* Owned by thread.c. */
     tid_t tid;                 /* Thread identifier. */
@@ -112,16 +115,31 @@ typedef struct thread {
     /** #Project 1: Alarm Clock */
     int64_t wakeup_tick; /* 활성화 틱 */
 
+    /** #Priority Scheduling - Synchronization */
+    struct heap_elem wait_elem;     /* semaphore 대기 힙 원소 */
+    struct semaphore *blocked_sema; /* 대기중인 semaphore */
+    struct condition *wait_cond;    /* 대기중인 condition */
+    struct heap_elem *cond_elem;    /* wait_cond 대기 힙 원소 */
+    uint64_t wait_seq;              /* 같은 우선순위 사이의 대기 순서 */
+
     /** #Project 1: Priority Donation */
     int original_priority;          /* 기존 Priority */
     struct lock *wait_lock;         /* 대기중인 lock */
-    struct list donations;          /* Donation List. */
-    struct list_elem donation_elem; /* Donation Element. */
+    struct list held_locks;         /* 보유 중인 lock 리스트 */
+
+    /** #Project 1: Reader-Writer Lock */
+    struct rwlock *wait_rwlock;                 /* reader가 빠지기를 기다리는 rwlock */
+    struct rw_hold read_holds[RW_HOLD_MAX];     /* 공유 모드로 보유 중인 rwlock */
 
     /** #Project 1: Advanced Scheduler */
     int niceness;              /* Niceness. */
     int recent_cpu;            /* 최근 CPU 점유 시간 */
-    struct list_elem all_elem; /* 살아있는 모든 Thread 연결 */
+    int recent_cpu_epoch;      /* recent_cpu 가 반영한 감쇠 횟수 */
+    struct list_elem stale_elem; /* 감쇠가 밀린 block 쓰레드 리스트 원소 */
+    bool stale;                /* stale_elem 이 리스트에 들어 있는지 */
+
+    /** #Project 3: Malloc Magazine */
+    struct magazine magazines[MAGAZINE_CNT]; /* 크기별로 캐시한 free 블록 (malloc.c) */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -147,6 +165,9 @@ typedef struct thread {
 #ifdef VM
     /* Table for whole virtual memory owned by thread. */
     struct supplemental_page_table spt;
+
+    /** #Project 3: Stack Growth */
+    uintptr_t user_rsp;  // 시스템 콜 진입 시점의 사용자 rsp (커널 모드 폴트 판단용)
 #endif
 
     /* Owned by thread.c. */
@@ -162,25 +183,22 @@ extern bool thread_mlfqs;
 /** #Project 1: Alarm Clock 함수 */
 void thread_sleep(int64_t ticks);
 void thread_awake(int64_t ticks);
-void update_next_tick_to_awake(int64_t ticks);
-int64_t get_next_tick_to_awake(void);
+long long thread_wheel_moves(void);
 
 /** #Project 1: Priority Scheduling 함수 */
 void test_max_priority(void);
-bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
 /** #Project 1: Priority Donation 함수  */
 void donate_priority(void);
-void remove_with_lock(struct lock *lock);
 void refresh_priority(void);
+long long thread_donation_scans(void);
 
 /** #Project 1: Advance Scheduler 함수 */
 void mlfqs_priority(struct thread *t);
 void mlfqs_recent_cpu(struct thread *t);
 void mlfqs_load_avg(void);
 void mlfqs_increment(void);
-void mlfqs_recalc_recent_cpu(void);
-void mlfqs_recalc_priority(void);
+void mlfqs_tick(int64_t ticks);
 
 void thread_init(void);
 void thread_start(void);
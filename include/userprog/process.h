@@ -27,9 +27,15 @@ struct container{
 	size_t page_read_bytes;
 	size_t page_zero_bytes;
 	bool writable;
+	uint8_t *seg_start;   // 이 페이지가 속한 세그먼트의 첫 페이지
+	uint8_t *seg_end;     // 세그먼트의 마지막 페이지 다음 주소
 
 };
 
+/** #Project 3: Anonymous Page 실행 파일 세그먼트의 지연 로딩 */
+bool lazy_load_segment(struct page *page, void *aux);
+bool lazy_load_same_segment(const void *aux_a, const void *aux_b);
+
 #define STDIN 1
 #define STDOUT 2
 #define STDERR 3
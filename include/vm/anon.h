@@ -1,5 +1,6 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
+#include <stddef.h>
 #include "vm/vm.h"
 struct page;
 enum vm_type;
@@ -9,7 +10,7 @@ enum vm_type;
 struct anon_page {
 
     // struct anon_page anon;
-
+    size_t swap_slot;   /* Swap slot holding the page, BITMAP_ERROR if resident. */
 };
 
 void vm_anon_init (void);
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/list.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -49,6 +50,9 @@ struct page {
 
 	/* Your implementation */
 	struct hash_elem hash_elem ;
+	struct thread *owner;  /* Thread whose page table maps this page. */
+	struct list_elem share_elem;  /* Element in the frame's page list. */
+	bool prefetched;       /* Mapped by fault-around, not yet touched. */
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
 	union {
@@ -64,7 +68,12 @@ struct page {
 /* The representation of "frame" */
 struct frame {
 	void *kva;
-	struct page *page;
+	struct page *page;            /* One of the pages in PAGES. */
+	struct list pages;            /* Pages mapping this frame. */
+	int share_cnt;                /* Length of PAGES; >1 while shared COW. */
+	struct list_elem frame_elem;  /* Element in the global frame table. */
+	bool pinned;                  /* Never chosen as a victim while set. */
+	bool evicting;                /* PAGE is being written out. */
 };
 
 /* The function table for page operations.
@@ -100,7 +109,11 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+extern size_t fault_around_pages;
+extern size_t stack_limit_pages;
+
 void vm_init (void);
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -110,6 +123,7 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+void vm_free_frame (struct page *page);
 enum vm_type page_get_type (struct page *page);
 
 
@@ -406,9 +406,3 @@ bool less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux)
 void action_func (struct hash_elem *e, void *aux){
 
 }
-
-void hash_page_destory(struct hash_elem *e, void *aux){
-	struct page *page = hash_entry(e,struct page, hash_elem);
-	destroy (page);
-	free (page);
-}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/* Priority queue.
+
+   See heap.h for basic information. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes heap H to compare elements using LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->elem_cnt++;
+}
+
+/* Returns the largest element in H, which must not be empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (!heap_empty (h));
+
+	return h->root;
+}
+
+/* Removes the largest element from H, which must not be empty,
+   and returns it.  If more than one element is largest, which
+   one is returned is unspecified; callers that want FIFO order
+   among equals must break ties in their `less' function. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (!heap_empty (h));
+
+	top = h->root;
+	h->root = merge_pairs (h, top->child);
+	h->elem_cnt--;
+	return top;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Unlink E, and with it its subtree, from its siblings. */
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+
+	h->root = meld (h, h->root, merge_pairs (h, e->child));
+	h->elem_cnt--;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Joins the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must have
+   no siblings. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (h->less (a, b, h->aux)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's leftmost child. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Joins the list of sibling trees starting at FIRST into a single
+   tree and returns its root, or a null pointer if FIRST is null.
+   Pairs are melded left to right, then the pairs right to left,
+   which is what keeps the amortized cost logarithmic. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;     /* Melded pairs, last first. */
+	struct heap_elem *root = NULL;
+
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = first->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		a = meld (h, a, b);
+		a->next = pairs;
+		pairs = a;
+	}
+
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+	if (root != NULL)
+		root->prev = NULL;
+	return root;
+}
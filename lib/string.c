@@ -1,5 +1,15 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* A machine word that may alias objects of any type. */
+typedef uint64_t __attribute__ ((__may_alias__)) word_t;
+#define WORD_SIZE sizeof (word_t)
+
+/* Blocks at least this long are moved with `rep movsq' and
+   `rep stosq', whose startup cost shorter blocks do not repay;
+   those move a word per iteration instead. */
+#define REP_MIN 256
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -7,10 +17,40 @@ void *
 memcpy (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
 	const unsigned char *src = src_;
+	size_t words;
 
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
+	/* Aligned whole words, as in page copies in fork and the VM:
+	   no head or tail to take care of. */
+	if (size >= REP_MIN && size % WORD_SIZE == 0
+			&& ((uintptr_t) dst | (uintptr_t) src) % WORD_SIZE == 0) {
+		words = size / WORD_SIZE;
+		asm volatile ("rep movsq"
+				: "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+		return dst_;
+	}
+
+	if (size >= REP_MIN) {
+		/* Align the destination, then let the CPU move the words. */
+		for (; (uintptr_t) dst % WORD_SIZE != 0; size--)
+			*dst++ = *src++;
+		words = size / WORD_SIZE;
+		size %= WORD_SIZE;
+		asm volatile ("rep movsq"
+				: "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+	} else if (((uintptr_t) dst ^ (uintptr_t) src) % WORD_SIZE == 0) {
+		/* Both can be brought to a word boundary together. */
+		for (; size > 0 && (uintptr_t) dst % WORD_SIZE != 0; size--)
+			*dst++ = *src++;
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			*(word_t *) dst = *(const word_t *) src;
+			dst += WORD_SIZE;
+			src += WORD_SIZE;
+		}
+	}
+
 	while (size-- > 0)
 		*dst++ = *src++;
 
@@ -52,6 +92,15 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	/* Skip equal words; the differing byte, if any, is then
+	   within the next word. */
+	for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+		if (*(const word_t *) a != *(const word_t *) b)
+			break;
+		a += WORD_SIZE;
+		b += WORD_SIZE;
+	}
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -257,9 +306,36 @@ strtok_r (char *s, const char *delimiters, char **save_ptr) {
 void *
 memset (void *dst_, int value, size_t size) {
 	unsigned char *dst = dst_;
+	word_t pattern = (unsigned char) value * 0x0101010101010101ULL;
+	size_t words;
 
 	ASSERT (dst != NULL || size == 0);
 
+	/* Aligned whole words, as in page zeroing in palloc: no head
+	   or tail to take care of. */
+	if (size >= REP_MIN && size % WORD_SIZE == 0
+			&& (uintptr_t) dst % WORD_SIZE == 0) {
+		words = size / WORD_SIZE;
+		asm volatile ("rep stosq"
+				: "+D" (dst), "+c" (words) : "a" (pattern) : "memory");
+		return dst_;
+	}
+
+	for (; size > 0 && (uintptr_t) dst % WORD_SIZE != 0; size--)
+		*dst++ = value;
+
+	if (size >= REP_MIN) {
+		words = size / WORD_SIZE;
+		size %= WORD_SIZE;
+		asm volatile ("rep stosq"
+				: "+D" (dst), "+c" (words) : "a" (pattern) : "memory");
+	} else {
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			*(word_t *) dst = pattern;
+			dst += WORD_SIZE;
+		}
+	}
+
 	while (size-- > 0)
 		*dst++ = value;
 
@@ -0,0 +1,42 @@
+/* Child process for par-read.
+   Reads the file its parent wrote for it PASS_CNT times over and
+   checks the contents each time. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/filesys/extended/par-read.h"
+#include "tests/lib.h"
+
+static char expected[FILE_SIZE];
+static char buf[FILE_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  char name[16];
+  int child_idx;
+  int fd, pass;
+
+  test_name = "child-par-read";
+  quiet = true;
+
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  snprintf (name, sizeof name, "par%d", child_idx);
+
+  random_init (0);
+  random_bytes (expected, sizeof expected);
+
+  CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+  for (pass = 0; pass < PASS_CNT; pass++) 
+    {
+      seek (fd, 0);
+      CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read \"%s\"", name);
+      compare_bytes (buf, expected, sizeof buf, 0, name);
+    }
+  close (fd);
+
+  return child_idx;
+}
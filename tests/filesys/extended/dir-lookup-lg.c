@@ -0,0 +1,47 @@
+/* Fills the root directory with 10,000 entries, then opens files
+   chosen at random among them.  The kernel reports how many
+   directory entries each name lookup examined on average. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 10000
+#define OPEN_CNT 2000
+
+void
+test_main (void) 
+{
+  char name[16];
+  int i;
+
+  msg ("creating %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "file%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+
+  msg ("opening %d files at random", OPEN_CNT);
+  random_init (0);
+  for (i = 0; i < OPEN_CNT; i++) 
+    {
+      int fd;
+
+      snprintf (name, sizeof name, "file%lu", random_ulong () % FILE_CNT);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      close (fd);
+    }
+
+  msg ("removing %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "file%d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+# The lookup cost depends on the directory index; only its presence
+# is checked.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+fail "missing directory lookup statistics\n"
+  if !grep (/^Directory: \d+ lookups, \d+\.\d\d entries examined per lookup$/, @output);
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-lookup-lg) begin
+(dir-lookup-lg) creating 10000 files
+(dir-lookup-lg) opening 2000 files at random
+(dir-lookup-lg) removing 10000 files
+(dir-lookup-lg) end
+EOF
+pass;
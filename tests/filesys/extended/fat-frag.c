@@ -0,0 +1,40 @@
+/* Creates and removes a couple of thousand files of assorted sizes,
+   keeping only a handful alive at a time, so that the free space
+   on disk becomes thoroughly fragmented.  The kernel reports the
+   average run length of the cluster chains it handed out. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 2000           /* Files created in total. */
+#define LIVE_CNT 8              /* Files alive at any time. */
+#define MAX_SECTORS 16          /* Largest file, in sectors. */
+
+void
+test_main (void) 
+{
+  char name[LIVE_CNT][16];
+  int i;
+
+  random_init (0);
+  msg ("creating and removing %d files, %d alive at a time",
+       FILE_CNT, LIVE_CNT);
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      int slot = i % LIVE_CNT;
+      size_t size = random_ulong () % (MAX_SECTORS * 512) + 1;
+
+      if (i >= LIVE_CNT && !remove (name[slot]))
+        fail ("remove \"%s\" failed", name[slot]);
+      snprintf (name[slot], sizeof name[slot], "frag%d", i);
+      if (!create (name[slot], size))
+        fail ("create \"%s\" of %zu bytes failed", name[slot], size);
+    }
+
+  msg ("removing the last %d files", LIVE_CNT);
+  for (i = 0; i < LIVE_CNT; i++)
+    CHECK (remove (name[i]), "remove \"%s\"", name[i]);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+# The run length depends on the allocator; only its presence is checked.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+fail "missing FAT allocation statistics\n"
+  if !grep (/^FAT: \d+ clusters allocated in \d+ runs, average run length \d+\.\d\d$/, @output);
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fat-frag) begin
+(fat-frag) creating and removing 2000 files, 8 alive at a time
+(fat-frag) removing the last 8 files
+(fat-frag) remove "frag1992"
+(fat-frag) remove "frag1993"
+(fat-frag) remove "frag1994"
+(fat-frag) remove "frag1995"
+(fat-frag) remove "frag1996"
+(fat-frag) remove "frag1997"
+(fat-frag) remove "frag1998"
+(fat-frag) remove "frag1999"
+(fat-frag) end
+EOF
+pass;
@@ -0,0 +1,55 @@
+/* Reads a large file at random offsets, so that every read has to
+   map an arbitrary file offset to its cluster.  The kernel reports
+   how many FAT chain-walk steps each mapping took on average. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)  /* Must fit on the 2 MB scratch disk. */
+#define BLOCK_SIZE 4096
+#define READ_CNT 2000
+
+static unsigned buf[BLOCK_SIZE / sizeof (unsigned)];
+
+void
+test_main (void) 
+{
+  const char *file_name = "bigfile";
+  size_t ofs;
+  int fd, i;
+
+  CHECK (create (file_name, FILE_SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+
+  /* Every word holds its own file offset. */
+  msg ("write \"%s\"", file_name);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE) 
+    {
+      size_t j;
+
+      for (j = 0; j < BLOCK_SIZE / sizeof (unsigned); j++)
+        buf[j] = ofs + j * sizeof (unsigned);
+      if (write (fd, buf, BLOCK_SIZE) != BLOCK_SIZE)
+        fail ("write %zu bytes at offset %zu failed", (size_t) BLOCK_SIZE, ofs);
+    }
+
+  msg ("read \"%s\" at %d random offsets", file_name, READ_CNT);
+  random_init (0);
+  for (i = 0; i < READ_CNT; i++) 
+    {
+      unsigned word;
+
+      ofs = random_ulong () % (FILE_SIZE / sizeof word) * sizeof word;
+      seek (fd, ofs);
+      if (read (fd, &word, sizeof word) != sizeof word)
+        fail ("read at offset %zu failed", ofs);
+      if (word != ofs)
+        fail ("offset %zu holds %u", ofs, word);
+    }
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  CHECK (remove (file_name), "remove \"%s\"", file_name);
+}
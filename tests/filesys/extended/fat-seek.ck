@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+# The step count depends on the chain cache; only its presence is checked.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+fail "missing chain-walk statistics\n"
+  if !grep (/^Inode: \d+ chain lookups, \d+\.\d\d chain-walk steps per lookup$/, @output);
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fat-seek) begin
+(fat-seek) create "bigfile"
+(fat-seek) open "bigfile"
+(fat-seek) write "bigfile"
+(fat-seek) read "bigfile" at 2000 random offsets
+(fat-seek) close "bigfile"
+(fat-seek) remove "bigfile"
+(fat-seek) end
+EOF
+pass;
@@ -0,0 +1,65 @@
+/* Grows an empty file to 1 MB by writing three sectors far apart,
+   then checks that everything in between reads back as zeros.
+   The regions never written must not cost any disk writes, which
+   the check script verifies from the disk statistics. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)
+#define BLOCK_SIZE 512
+
+static const size_t offsets[] = {0, FILE_SIZE / 2, FILE_SIZE - BLOCK_SIZE};
+#define OFFSET_CNT (sizeof offsets / sizeof *offsets)
+
+static char block[BLOCK_SIZE];
+static char buf[BLOCK_SIZE];
+
+/* Returns the byte expected at offset OFS of the file. */
+static char
+expected_byte (size_t ofs) 
+{
+  size_t i;
+
+  for (i = 0; i < OFFSET_CNT; i++)
+    if (ofs >= offsets[i] && ofs < offsets[i] + BLOCK_SIZE)
+      return 'a' + i;
+  return 0;
+}
+
+void
+test_main (void) 
+{
+  const char *file_name = "sparse";
+  size_t ofs, i;
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (i = 0; i < OFFSET_CNT; i++) 
+    {
+      memset (block, 'a' + i, BLOCK_SIZE);
+      seek (fd, offsets[i]);
+      CHECK (write (fd, block, BLOCK_SIZE) == BLOCK_SIZE,
+             "write %d bytes at offset %zu", BLOCK_SIZE, offsets[i]);
+    }
+  CHECK (filesize (fd) == FILE_SIZE, "filesize \"%s\"", file_name);
+
+  msg ("verify \"%s\"", file_name);
+  seek (fd, 0);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE) 
+    {
+      if (read (fd, buf, BLOCK_SIZE) != BLOCK_SIZE)
+        fail ("read %d bytes at offset %zu failed", BLOCK_SIZE, ofs);
+      for (i = 0; i < BLOCK_SIZE; i++)
+        if (buf[i] != expected_byte (ofs + i))
+          fail ("byte %zu is %d, expected %d",
+                ofs + i, buf[i], expected_byte (ofs + i));
+    }
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+  CHECK (remove (file_name), "remove \"%s\"", file_name);
+}
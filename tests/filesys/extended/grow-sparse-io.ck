@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The file spans 2048 sectors.  Zero-filling them would take at least
+# as many writes; besides the three written sectors, the rest of the
+# run (loading the programs, FAT and inodes) needs well under half.
+my ($writes) = map (/^hd0:1: \d+ reads, (\d+) writes$/, @output);
+fail "missing disk statistics for hd0:1\n" if !defined $writes;
+fail "$writes writes to hd0:1, but holes should not be written\n"
+  if $writes >= 1024;
+
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-sparse-io) begin
+(grow-sparse-io) create "sparse"
+(grow-sparse-io) open "sparse"
+(grow-sparse-io) write 512 bytes at offset 0
+(grow-sparse-io) write 512 bytes at offset 524288
+(grow-sparse-io) write 512 bytes at offset 1048064
+(grow-sparse-io) filesize "sparse"
+(grow-sparse-io) verify "sparse"
+(grow-sparse-io) close "sparse"
+(grow-sparse-io) remove "sparse"
+(grow-sparse-io) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Creates 1,500 files and keeps all of them open at once, then
+   opens each of them a second time, so that most opens happen with
+   well over a thousand inodes already open.  The kernel reports the
+   average cost of an inode open. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 1500
+
+static int fds[FILE_CNT];
+
+void
+test_main (void) 
+{
+  char name[16];
+  int i;
+
+  msg ("creating %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "open%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+    }
+
+  msg ("opening all of them");
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "open%d", i);
+      if ((fds[i] = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+    }
+
+  msg ("opening each again while all are open");
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      int fd;
+
+      snprintf (name, sizeof name, "open%d", i);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      close (fd);
+    }
+
+  msg ("closing and removing them");
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (name, sizeof name, "open%d", i);
+      close (fds[i]);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+# The cycle count varies from run to run; only its presence is checked.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+fail "missing inode open statistics\n"
+  if !grep (/^Inode: \d+ opens, \d+ cycles per open$/, @output);
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(open-many) begin
+(open-many) creating 1500 files
+(open-many) opening all of them
+(open-many) opening each again while all are open
+(open-many) closing and removing them
+(open-many) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Readers of separate files must not serialize behind one another:
+# running more of them at once may not cost much aggregate throughput.
+foreach my $readers (1, 2, 4) {
+    my ($line) = grep (/^\(par-read\) $readers reader\(s\): /, @output);
+    fail "missing timing for $readers reader(s)\n" if !defined $line;
+    my ($ratio) = $line =~ /: \d+ cycles per KB read, (\d+\.\d\d) times the throughput of 1 reader$/
+      or fail "malformed timing: $line\n";
+    fail "$readers reader(s) reached only $ratio times the throughput "
+      . "of 1 reader\n" if $ratio < 0.75;
+}
+@output = grep (!/cycles per KB read/, @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(par-read) begin
+(par-read) create "par0"
+(par-read) open "par0"
+(par-read) write "par0"
+(par-read) create "par1"
+(par-read) open "par1"
+(par-read) write "par1"
+(par-read) create "par2"
+(par-read) open "par2"
+(par-read) write "par2"
+(par-read) create "par3"
+(par-read) open "par3"
+(par-read) write "par3"
+(par-read) running 1 reader(s)
+(par-read) running 2 reader(s)
+(par-read) running 4 reader(s)
+(par-read) remove "par0"
+(par-read) remove "par1"
+(par-read) remove "par2"
+(par-read) remove "par3"
+(par-read) end
+EOF
+pass;
@@ -0,0 +1,11 @@
+#ifndef TESTS_FILESYS_EXTENDED_PAR_READ_H
+#define TESTS_FILESYS_EXTENDED_PAR_READ_H
+
+/* All READER_MAX files together fit in the 64-sector buffer cache,
+   so every round measures the same cached path rather than how much
+   the readers evict one another. */
+#define FILE_SIZE 4096          /* Size of each reader's file. */
+#define PASS_CNT 128            /* Times each reader reads its file. */
+#define READER_MAX 4            /* Most readers run at once. */
+
+#endif /* tests/filesys/extended/par-read.h */
@@ -0,0 +1,101 @@
+/* Puts a thousand threads to sleep for assorted durations, several
+   times each, and checks that none of them wakes up before its
+   deadline.
+
+   Also checks how much work the timing wheel did for them.  A sleep
+   of fewer than 65 ticks goes straight into the slot for its
+   deadline, and a longer one (up to 4096 ticks) is filed one level
+   up and moved down once, when its slot comes around.  A thread
+   preempted inside timer_sleep() has less time left by the time it
+   is filed, so it may skip the move, but no sleep is ever moved
+   twice.  The wheel must therefore make no more moves than there
+   are sleeps of 65 ticks or more, however many threads are asleep
+   at once. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000
+#define ITERATIONS 3
+#define MAX_SLEEP 400           /* Spans more than one wheel level. */
+
+static struct semaphore done;   /* Upped by each sleeper when it exits. */
+static int early_cnt;           /* Wakeups that came before the deadline. */
+
+static void sleeper (void *);
+static int64_t sleep_duration (int id, int iteration);
+
+void
+test_alarm_stress (void) 
+{
+  long long moves, max_moves;
+  int i, j;
+
+  msg ("Creating %d threads to sleep %d times each.", THREAD_CNT, ITERATIONS);
+
+  max_moves = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    for (j = 0; j < ITERATIONS; j++)
+      if (sleep_duration (i, j) >= 65)
+        max_moves++;
+
+  sema_init (&done, 0);
+  early_cnt = 0;
+  moves = thread_wheel_moves ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, (void *) (intptr_t) i)
+          == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  moves = thread_wheel_moves () - moves;
+
+  if (early_cnt != 0)
+    fail ("%d wakeups came before their deadline", early_cnt);
+  msg ("All threads woke up, none of them early.");
+  if (moves > max_moves)
+    fail ("timing wheel moved sleepers %lld times, but only %lld sleeps "
+          "were long enough to need a move", moves, max_moves);
+  msg ("No sleep was moved down the wheel more than once.");
+}
+
+/* Returns how long sleeper ID sleeps on its ITERATION'th round. */
+static int64_t
+sleep_duration (int id, int iteration) 
+{
+  return 1 + (id * 37 + iteration * 101) % MAX_SLEEP;
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t duration = sleep_duration (id, i);
+      int64_t deadline = timer_ticks () + duration;
+
+      timer_sleep (duration);
+      if (timer_ticks () < deadline)
+        {
+          enum intr_level old_level = intr_disable ();
+          early_cnt++;
+          intr_set_level (old_level);
+        }
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-stress) begin
+(alarm-stress) Creating 1000 threads to sleep 3 times each.
+(alarm-stress) All threads woke up, none of them early.
+(alarm-stress) No sleep was moved down the wheel more than once.
+(alarm-stress) end
+EOF
+pass;
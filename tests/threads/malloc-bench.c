@@ -0,0 +1,162 @@
+/* Measures malloc() and free() on small objects, the sizes of the
+   VM's page and frame records and lazy-load arguments.  Several
+   threads at the same priority each keep a set of live objects
+   and, over and over, free a random one and allocate another of a
+   random size in its place, so that the timer switches among them
+   while their allocations interleave.  Every object is tagged with
+   its owner and size so that blocks handed out twice fail the
+   test.
+
+   This is done first with objects of 32 to 128 bytes, which come
+   from the per-thread magazines, and then with objects of 129 to
+   256 bytes, which take the descriptor's lock on every call.  A
+   magazine is left with MAGAZINE_BATCH (16) blocks whenever it is
+   refilled or drained, so it takes at least that many calls to
+   need the lock again; the small objects must not take the lock
+   more often than that, apart from each thread's first refill
+   and last drain.  The large objects must take it on every call,
+   which shows the count is taken.  The average number of cycles
+   per malloc/free pair is only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 4
+#define SLOT_CNT 64
+#define PAIR_CNT 250000
+#define BATCH_CNT 16            /* Blocks a magazine moves at once. */
+
+/* Calls to malloc() and free() in one run. */
+#define CALL_CNT (THREAD_CNT * (2LL * PAIR_CNT + SLOT_CNT))
+
+struct object 
+  {
+    uint8_t *p;                 /* Allocated object. */
+    size_t size;                /* Its size in bytes. */
+  };
+
+struct worker 
+  {
+    int id;
+    size_t min_size;            /* Smallest object size. */
+    size_t max_size;            /* Largest object size. */
+    struct object objects[SLOT_CNT];
+    struct semaphore *done;     /* Upped when finished. */
+  };
+
+static thread_func worker;
+static uint64_t run_bench (size_t min_size, size_t max_size,
+                           long long *lock_cnt);
+static void release (struct worker *, struct object *);
+
+void
+test_malloc_bench (void) 
+{
+  uint64_t small_cycles, large_cycles;
+  long long small_locks, large_locks, max_small_locks;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d threads doing %d malloc/free pairs each, twice.",
+       THREAD_CNT, PAIR_CNT);
+  small_cycles = run_bench (32, 128, &small_locks);
+  large_cycles = run_bench (129, 256, &large_locks);
+
+  max_small_locks = CALL_CNT / BATCH_CNT + 2 * THREAD_CNT * MAGAZINE_CNT;
+  if (small_locks > max_small_locks)
+    fail ("32- to 128-byte objects took the lock %lld times in %lld calls, "
+          "more than %lld", small_locks, CALL_CNT, max_small_locks);
+  msg ("32 to 128 bytes took the lock at most once per %d calls.",
+       BATCH_CNT);
+  if (large_locks < CALL_CNT)
+    fail ("129- to 256-byte objects took the lock %lld times in %lld calls",
+          large_locks, CALL_CNT);
+  msg ("129 to 256 bytes took the lock on every call.");
+
+  msg ("32 to 128 bytes: %"PRIu64" cycles per malloc/free pair.",
+       small_cycles);
+  msg ("129 to 256 bytes: %"PRIu64" cycles per malloc/free pair.",
+       large_cycles);
+}
+
+/* Runs THREAD_CNT workers on objects of MIN_SIZE to MAX_SIZE
+   bytes, stores the number of times they took a descriptor's
+   lock in *LOCK_CNT, and returns the average number of cycles
+   per malloc/free pair. */
+static uint64_t
+run_bench (size_t min_size, size_t max_size, long long *lock_cnt) 
+{
+  static struct worker workers[THREAD_CNT];
+  struct semaphore done;
+  uint64_t start, cycles;
+  int i;
+
+  sema_init (&done, 0);
+  *lock_cnt = malloc_lock_acquisitions ();
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      workers[i].id = i;
+      workers[i].min_size = min_size;
+      workers[i].max_size = max_size;
+      workers[i].done = &done;
+      snprintf (name, sizeof name, "worker %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker, &workers[i]) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  cycles = rdtsc () - start;
+  *lock_cnt = malloc_lock_acquisitions () - *lock_cnt;
+  return cycles / (THREAD_CNT * PAIR_CNT);
+}
+
+static void
+worker (void *w_) 
+{
+  struct worker *w = w_;
+  size_t span = w->max_size - w->min_size + 1;
+  unsigned seed = w->id + 1;
+  int i;
+
+  for (i = 0; i < PAIR_CNT; i++)
+    {
+      struct object *o;
+
+      seed = seed * 1103515245 + 12345;
+      o = &w->objects[(seed >> 8) % SLOT_CNT];
+      release (w, o);
+
+      o->size = w->min_size + (seed >> 16) % span;
+      o->p = malloc (o->size);
+      if (o->p == NULL)
+        fail ("worker %d couldn't allocate %zu bytes", w->id, o->size);
+      o->p[0] = w->id;
+      o->p[o->size - 1] = o->size;
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    release (w, &w->objects[i]);
+  sema_up (w->done);
+}
+
+/* Checks the tags in object O and frees it. */
+static void
+release (struct worker *w, struct object *o) 
+{
+  if (o->p == NULL)
+    return;
+  if (o->p[0] != w->id || o->p[o->size - 1] != (uint8_t) o->size)
+    fail ("worker %d found a %zu-byte object overwritten", w->id, o->size);
+  free (o->p);
+  o->p = NULL;
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The "cycles per malloc/free pair" lines carry cycle counts that
+# depend on the machine; they are there for people reading the
+# output, so leave them out of the comparison.
+compare_output ("run", [grep (!/cycles per malloc\/free pair/, @output)], [<<'EOF']);
+(malloc-bench) begin
+(malloc-bench) 4 threads doing 250000 malloc/free pairs each, twice.
+(malloc-bench) 32 to 128 bytes took the lock at most once per 16 calls.
+(malloc-bench) 129 to 256 bytes took the lock on every call.
+(malloc-bench) end
+EOF
+pass;
@@ -0,0 +1,120 @@
+/* Measures the page allocator under a mix of single- and
+   multi-page requests.  A fixed pseudo-random sequence keeps a
+   set of slots filled from the user pool: each step frees
+   whatever a slot holds and puts a new allocation of 1 page, or
+   now and then 2 to 8 pages, in its place.  After every phase
+   the largest free block left in the pool must still be at least
+   half the size it started at: the slots never hold more than a
+   few hundred pages, so a buddy allocator may have to split the
+   largest block once to serve them but should never need more,
+   however long the churn goes on.  Every page is tagged with its
+   slot so that overlapping allocations fail the test.  Once every
+   slot is freed, the pool must have merged its blocks back into
+   the same largest block it started with.  The average cycles per
+   allocation and per free are only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define SLOT_CNT 64
+#define PHASE_CNT 8
+#define STEP_CNT 500
+
+struct slot
+  {
+    uint8_t *pages;
+    size_t page_cnt;
+  };
+
+static struct slot slots[SLOT_CNT];
+static unsigned seed = 1;
+
+static unsigned next_random (void);
+static uint64_t release_slot (int);
+
+void
+test_palloc_bench (void) 
+{
+  uint64_t start, alloc_cycles, free_cycles;
+  size_t largest, phase_largest;
+  int phase, step, i;
+  size_t j;
+
+  msg ("Running %d phases of %d steps over %d slots.",
+       PHASE_CNT, STEP_CNT, SLOT_CNT);
+  largest = palloc_largest_free (PAL_USER);
+  msg ("Largest free block at start: %zu pages.", largest);
+
+  for (phase = 0; phase < PHASE_CNT; phase++) 
+    {
+      alloc_cycles = free_cycles = 0;
+      for (step = 0; step < STEP_CNT; step++) 
+        {
+          struct slot *s;
+          unsigned r = next_random ();
+
+          i = r % SLOT_CNT;
+          s = &slots[i];
+
+          free_cycles += release_slot (i);
+
+          s->page_cnt = (r >> 8) % 4 == 0 ? 2 + (r >> 12) % 7 : 1;
+          start = rdtsc ();
+          s->pages = palloc_get_multiple (PAL_USER, s->page_cnt);
+          alloc_cycles += rdtsc () - start;
+          if (s->pages == NULL)
+            fail ("couldn't allocate %zu pages", s->page_cnt);
+          for (j = 0; j < s->page_cnt; j++)
+            s->pages[j * PGSIZE] = i;
+        }
+      phase_largest = palloc_largest_free (PAL_USER);
+      msg ("Phase %d: alloc %"PRIu64" cycles, free %"PRIu64" cycles, "
+           "largest free block %zu pages.", phase,
+           alloc_cycles / STEP_CNT, free_cycles / STEP_CNT, phase_largest);
+      if (2 * phase_largest < largest)
+        fail ("largest free block fell to %zu pages in phase %d, "
+              "from %zu at the start", phase_largest, phase, largest);
+    }
+  msg ("Largest free block stayed at least half its starting size.");
+
+  for (i = 0; i < SLOT_CNT; i++)
+    release_slot (i);
+  if (palloc_largest_free (PAL_USER) != largest)
+    fail ("largest free block is %zu pages after freeing everything, "
+          "not %zu", palloc_largest_free (PAL_USER), largest);
+  msg ("Freed blocks merged back together.");
+}
+
+/* Checks the tags in slot I's pages and frees them.  Returns
+   the cycles spent in palloc_free_multiple(). */
+static uint64_t
+release_slot (int i) 
+{
+  struct slot *s = &slots[i];
+  uint64_t start, cycles;
+  size_t j;
+
+  if (s->pages == NULL)
+    return 0;
+  for (j = 0; j < s->page_cnt; j++)
+    if (s->pages[j * PGSIZE] != i)
+      fail ("slot %d page %zu was overwritten", i, j);
+  start = rdtsc ();
+  palloc_free_multiple (s->pages, s->page_cnt);
+  cycles = rdtsc () - start;
+  s->pages = NULL;
+  return cycles;
+}
+
+/* Returns the next number from a fixed linear congruential
+   sequence, so that every run makes the same requests. */
+static unsigned
+next_random (void) 
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 4;
+}
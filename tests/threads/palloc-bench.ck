@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The block sizes depend on the amount of memory and the cycle
+# counts on the machine; they are there for people reading the
+# output, so leave them out of the comparison.
+compare_output ("run", [grep (!/Phase \d+:|at start:/, @output)], [<<'EOF']);
+(palloc-bench) begin
+(palloc-bench) Running 8 phases of 500 steps over 64 slots.
+(palloc-bench) Largest free block stayed at least half its starting size.
+(palloc-bench) Freed blocks merged back together.
+(palloc-bench) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Checks that the idle thread keeps zeroed user pages ready.  The
+   main thread sleeps, so that the idle thread can zero free pages
+   ahead of time, and then asks for a batch of zeroed user pages,
+   scribbles on them and frees them.  It does this twice; the
+   idle thread only keeps a few dozen pages ready, so the second
+   batch can only be served from them if it refilled its stock
+   while we slept.  Every page must read back as all zeros.  The
+   kernel prints how many requests were served from the stock when
+   it shuts down, which the check then reads. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define PAGE_CNT 48
+#define ROUND_CNT 2
+
+void
+test_palloc_prezero (void) 
+{
+  static uint8_t *pages[PAGE_CNT];
+  int round, i;
+  size_t j;
+
+  msg ("Allocating %d zeroed user pages, %d times.", PAGE_CNT, ROUND_CNT);
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      /* Give the idle thread time to zero pages. */
+      timer_sleep (10);
+
+      for (i = 0; i < PAGE_CNT; i++)
+        {
+          pages[i] = palloc_get_page (PAL_USER | PAL_ZERO);
+          if (pages[i] == NULL)
+            fail ("couldn't allocate page %d", i);
+          for (j = 0; j < PGSIZE; j++)
+            if (pages[i][j] != 0)
+              fail ("page %d has byte %zu nonzero", i, j);
+        }
+
+      for (i = 0; i < PAGE_CNT; i++)
+        {
+          memset (pages[i], 0xff, PGSIZE);
+          palloc_free_page (pages[i]);
+        }
+    }
+  msg ("Every page was zeroed.");
+}
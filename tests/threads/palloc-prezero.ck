@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(palloc-prezero) begin
+(palloc-prezero) Allocating 48 zeroed user pages, 2 times.
+(palloc-prezero) Every page was zeroed.
+(palloc-prezero) end
+EOF
+
+# The statistics line comes after the test, at shutdown.  The test
+# sleeps before each batch, so all 96 of its requests should have
+# found a page the idle thread had zeroed already.
+my ($hits, $reqs);
+foreach (@output) {
+    ($hits, $reqs) = ($1, $2)
+      if /^Palloc: (\d+) of (\d+) zeroed user pages came pre-zeroed/;
+}
+fail "missing palloc statistics\n" if !defined ($hits);
+fail "only $hits of $reqs zeroed user pages came pre-zeroed\n"
+  if $hits < 96;
+pass;
@@ -0,0 +1,132 @@
+/* Measures the cost of releasing a lock while many donations are
+   outstanding.  The main thread holds a lock with a crowd of donors
+   of mixed priority waiting on it, plus fifty more locks with one
+   lower-priority waiter each.  It then releases the fifty locks one
+   at a time; the big lock's donors keep its priority above the
+   woken waiters, so no release switches threads, and each one has
+   to recompute the main thread's priority while every donation is
+   still in place.  After each release the main thread must still
+   have the priority of its highest donor.
+
+   This is done with ten donors and then with two hundred.  The
+   recomputation should only look at the locks still held, not at
+   every donor, so both runs must look at exactly 50 + 49 + ... + 1
+   held locks in all.  The average number of cycles per release is
+   only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define FEW_DONORS 10
+#define MANY_DONORS 200
+#define LOCK_CNT 50
+
+static int done_cnt;
+
+static thread_func acquire_thread_func;
+static uint64_t measure_release (int donor_cnt);
+
+void
+test_priority_donate_bench (void) 
+{
+  uint64_t few_cycles, many_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  msg ("Releasing %d locks with %d donors waiting, then with %d.",
+       LOCK_CNT, FEW_DONORS, MANY_DONORS);
+  few_cycles = measure_release (FEW_DONORS);
+  many_cycles = measure_release (MANY_DONORS);
+
+  msg ("All threads finished.");
+  msg ("Each release looked only at the locks still held.");
+  msg ("Average release with %d donors: %"PRIu64" cycles.",
+       FEW_DONORS, few_cycles);
+  msg ("Average release with %d donors: %"PRIu64" cycles.",
+       MANY_DONORS, many_cycles);
+}
+
+/* Sets up LOCK_CNT locks with one waiter each and a big lock with
+   DONOR_CNT donors, releases the LOCK_CNT locks, checks the main
+   thread's priority and how many held locks were looked at, and
+   returns the average number of cycles per release. */
+static uint64_t
+measure_release (int donor_cnt) 
+{
+  static struct lock locks[LOCK_CNT];
+  struct lock big;
+  long long scans, expected_scans;
+  uint64_t start, cycles;
+  int max_priority = PRI_DEFAULT;
+  int i;
+
+  done_cnt = 0;
+  for (i = 0; i < LOCK_CNT; i++)
+    {
+      lock_init (&locks[i]);
+      lock_acquire (&locks[i]);
+      thread_create ("waiter", PRI_DEFAULT + 1, acquire_thread_func,
+                     &locks[i]);
+    }
+
+  lock_init (&big);
+  lock_acquire (&big);
+  for (i = 0; i < donor_cnt; i++)
+    {
+      /* Mix the priorities so the donors arrive out of order. */
+      int priority = PRI_DEFAULT + 2 + (i * 7) % (PRI_MAX - PRI_DEFAULT - 1);
+
+      if (priority > max_priority)
+        max_priority = priority;
+      thread_create ("donor", priority, acquire_thread_func, &big);
+    }
+  if (thread_get_priority () != max_priority)
+    fail ("main has priority %d instead of %d",
+          thread_get_priority (), max_priority);
+
+  /* Releasing lock I leaves the other LOCK_CNT - I - 1 small
+     locks and the big one to look at. */
+  expected_scans = LOCK_CNT * (LOCK_CNT + 1) / 2;
+  cycles = 0;
+  scans = thread_donation_scans ();
+  for (i = 0; i < LOCK_CNT; i++)
+    {
+      start = rdtsc ();
+      lock_release (&locks[i]);
+      cycles += rdtsc () - start;
+      if (thread_get_priority () != max_priority)
+        fail ("main has priority %d instead of %d after release %d",
+              thread_get_priority (), max_priority, i);
+    }
+  scans = thread_donation_scans () - scans;
+
+  if (done_cnt != 0)
+    fail ("%d threads ran before the donors were released", done_cnt);
+  if (scans != expected_scans)
+    fail ("releases looked at %lld held locks with %d donors "
+          "instead of %lld", scans, donor_cnt, expected_scans);
+  lock_release (&big);
+  if (done_cnt != donor_cnt + LOCK_CNT)
+    fail ("%d threads finished instead of %d",
+          done_cnt, donor_cnt + LOCK_CNT);
+  return cycles / LOCK_CNT;
+}
+
+static void
+acquire_thread_func (void *lock_) 
+{
+  struct lock *lock = lock_;
+
+  lock_acquire (lock);
+  lock_release (lock);
+  done_cnt++;
+}
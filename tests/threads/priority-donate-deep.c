@@ -0,0 +1,71 @@
+/* Builds a chain of sixteen nested donations, twice as deep as
+   a fixed-depth donation walk would follow.  The main thread
+   holds lock 0.  Thread I, of priority PRI_DEFAULT + I, acquires
+   lock I and then blocks acquiring lock I - 1, held by thread
+   I - 1, so each new thread's priority must travel down the
+   whole chain to the main thread.  When the main thread releases
+   lock 0, the threads finish from the top of the chain down. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define DEPTH 16
+
+struct link 
+  {
+    int idx;
+    struct lock *first;         /* Lock to hold. */
+    struct lock *second;        /* Lock to wait for. */
+  };
+
+static thread_func link_thread_func;
+
+void
+test_priority_donate_deep (void) 
+{
+  struct lock locks[DEPTH + 1];
+  struct link links[DEPTH + 1];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  for (i = 0; i <= DEPTH; i++)
+    lock_init (&locks[i]);
+  lock_acquire (&locks[0]);
+
+  for (i = 1; i <= DEPTH; i++)
+    {
+      char name[16];
+
+      links[i].idx = i;
+      links[i].first = &locks[i];
+      links[i].second = &locks[i - 1];
+      snprintf (name, sizeof name, "link %d", i);
+      thread_create (name, PRI_DEFAULT + i, link_thread_func, &links[i]);
+      msg ("main should have priority %d.  Actual priority: %d.",
+           PRI_DEFAULT + i, thread_get_priority ());
+    }
+
+  lock_release (&locks[0]);
+  msg ("main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+link_thread_func (void *link_) 
+{
+  struct link *link = link_;
+
+  lock_acquire (link->first);
+  lock_acquire (link->second);
+  lock_release (link->second);
+  lock_release (link->first);
+  msg ("link %d finished", link->idx);
+}
@@ -0,0 +1,42 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-deep) begin
+(priority-donate-deep) main should have priority 32.  Actual priority: 32.
+(priority-donate-deep) main should have priority 33.  Actual priority: 33.
+(priority-donate-deep) main should have priority 34.  Actual priority: 34.
+(priority-donate-deep) main should have priority 35.  Actual priority: 35.
+(priority-donate-deep) main should have priority 36.  Actual priority: 36.
+(priority-donate-deep) main should have priority 37.  Actual priority: 37.
+(priority-donate-deep) main should have priority 38.  Actual priority: 38.
+(priority-donate-deep) main should have priority 39.  Actual priority: 39.
+(priority-donate-deep) main should have priority 40.  Actual priority: 40.
+(priority-donate-deep) main should have priority 41.  Actual priority: 41.
+(priority-donate-deep) main should have priority 42.  Actual priority: 42.
+(priority-donate-deep) main should have priority 43.  Actual priority: 43.
+(priority-donate-deep) main should have priority 44.  Actual priority: 44.
+(priority-donate-deep) main should have priority 45.  Actual priority: 45.
+(priority-donate-deep) main should have priority 46.  Actual priority: 46.
+(priority-donate-deep) main should have priority 47.  Actual priority: 47.
+(priority-donate-deep) link 16 finished
+(priority-donate-deep) link 15 finished
+(priority-donate-deep) link 14 finished
+(priority-donate-deep) link 13 finished
+(priority-donate-deep) link 12 finished
+(priority-donate-deep) link 11 finished
+(priority-donate-deep) link 10 finished
+(priority-donate-deep) link 9 finished
+(priority-donate-deep) link 8 finished
+(priority-donate-deep) link 7 finished
+(priority-donate-deep) link 6 finished
+(priority-donate-deep) link 5 finished
+(priority-donate-deep) link 4 finished
+(priority-donate-deep) link 3 finished
+(priority-donate-deep) link 2 finished
+(priority-donate-deep) link 1 finished
+(priority-donate-deep) main should have priority 31.  Actual priority: 31.
+(priority-donate-deep) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* The main thread holds an rwlock shared.  A writer blocks waiting
+   for it to leave and donates its priority to the main thread.
+   Then a higher-priority reader blocks behind the writer, and its
+   priority must reach the main thread through the writer.  When
+   the main thread releases the lock, the writer runs first, then
+   the reader preempts it as soon as the lock is free. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+static thread_func reader_thread_func;
+
+void
+test_priority_donate_rwlock (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  rwlock_read_release (&rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_write_acquire (rw);
+  msg ("writer: got the lock");
+  rwlock_write_release (rw);
+  msg ("writer: done");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_read_acquire (rw);
+  msg ("reader: got the lock shared");
+  rwlock_read_release (rw);
+  msg ("reader: done");
+}
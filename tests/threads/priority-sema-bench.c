@@ -0,0 +1,121 @@
+/* Measures the cost of waking one thread from a semaphore that
+   has many waiters.  Threads of mixed priorities, all higher than
+   the main thread's, block on one semaphore.  The main thread
+   then ups it once per waiter; each up switches straight to the
+   woken waiter, which checks that it comes after every waiter of
+   higher priority and after every earlier waiter of its own
+   priority.
+
+   This is done with ten waiters and then with two hundred and
+   fifty.  Queueing and then waking N waiters should take on the
+   order of N log N comparisons between waiters, so the test fails
+   if it takes more than 2 * N * ceil(log2 N).  Keeping the list
+   sorted, or scanning it for the best waiter, would take about
+   N * N / 4 or more.  The average number of cycles per wakeup is
+   only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define FEW_WAITERS 10
+#define MANY_WAITERS 250
+
+static struct semaphore sema;
+static int wake_cnt;
+static int last_priority;
+static int last_idx;
+static bool out_of_order;
+
+static thread_func waiter;
+static uint64_t measure_wakeup (int waiter_cnt);
+
+void
+test_priority_sema_bench (void) 
+{
+  uint64_t few_cycles, many_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  msg ("Blocking %d threads on one semaphore, then %d.",
+       FEW_WAITERS, MANY_WAITERS);
+  few_cycles = measure_wakeup (FEW_WAITERS);
+  many_cycles = measure_wakeup (MANY_WAITERS);
+
+  msg ("All threads woke in priority order.");
+  msg ("Comparisons between waiters stayed within N log N.");
+  msg ("Average wakeup with %d waiters: %"PRIu64" cycles.",
+       FEW_WAITERS, few_cycles);
+  msg ("Average wakeup with %d waiters: %"PRIu64" cycles.",
+       MANY_WAITERS, many_cycles);
+}
+
+/* Blocks WAITER_CNT threads on SEMA, wakes them all, checks how
+   many comparisons that took, and returns the average number of
+   cycles per wakeup. */
+static uint64_t
+measure_wakeup (int waiter_cnt) 
+{
+  long long compares, max_compares;
+  uint64_t start, cycles;
+  int log_cnt;
+  int i;
+
+  for (log_cnt = 0; (1 << log_cnt) < waiter_cnt; log_cnt++)
+    continue;
+  max_compares = 2LL * waiter_cnt * log_cnt;
+
+  sema_init (&sema, 0);
+  wake_cnt = 0;
+  last_priority = PRI_MAX + 1;
+  last_idx = -1;
+  out_of_order = false;
+  compares = sema_waiter_compares ();
+  for (i = 0; i < waiter_cnt; i++)
+    {
+      /* Mix the priorities so the waiters arrive out of order. */
+      int priority = PRI_DEFAULT + 1 + (i * 7) % (PRI_MAX - PRI_DEFAULT);
+
+      if (thread_create ("waiter", priority, waiter, (void *) (intptr_t) i)
+          == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < waiter_cnt; i++)
+    sema_up (&sema);
+  cycles = rdtsc () - start;
+  compares = sema_waiter_compares () - compares;
+
+  if (wake_cnt != waiter_cnt)
+    fail ("%d threads woke instead of %d", wake_cnt, waiter_cnt);
+  if (out_of_order)
+    fail ("waiters woke out of order");
+  if (compares > max_compares)
+    fail ("%lld comparisons to queue and wake %d waiters, "
+          "more than %lld", compares, waiter_cnt, max_compares);
+  return cycles / waiter_cnt;
+}
+
+static void
+waiter (void *idx_) 
+{
+  int idx = (intptr_t) idx_;
+  int priority = thread_get_priority ();
+
+  sema_down (&sema);
+  if (priority > last_priority
+      || (priority == last_priority && idx < last_idx))
+    out_of_order = true;
+  last_priority = priority;
+  last_idx = idx;
+  wake_cnt++;
+}
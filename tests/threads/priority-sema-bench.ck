@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The "Average wakeup" lines carry cycle counts that depend on the
+# machine; they are there for people reading the output, so leave
+# them out of the comparison.
+compare_output ("run", [grep (!/Average wakeup/, @output)], [<<'EOF']);
+(priority-sema-bench) begin
+(priority-sema-bench) Blocking 10 threads on one semaphore, then 250.
+(priority-sema-bench) All threads woke in priority order.
+(priority-sema-bench) Comparisons between waiters stayed within N log N.
+(priority-sema-bench) end
+EOF
+pass;
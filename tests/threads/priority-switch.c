@@ -0,0 +1,96 @@
+/* Measures the cost of a context switch with many threads ready.
+   A number of threads of equal priority each yield a number of
+   times, so every switch puts the yielding thread at the back of
+   its run queue.  The main thread, at the lowest priority, only
+   runs again once they are all gone, and takes the average number
+   of cycles per switch.
+
+   This is done twice with the same total number of switches, once
+   with two threads and once with two hundred.  Each yielder notes
+   its number as it yields.  None of them runs long enough to be
+   preempted, so they must take turns in exactly the order they
+   were created; the cycle counts are only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define FEW_THREADS 2
+#define MANY_THREADS 200
+#define SWITCH_CNT 10000
+
+static int thread_cnt;          /* Yielders in the current run. */
+static int yield_cnt;           /* Yields so far in the current run. */
+static int out_of_turn_cnt;     /* Yields by the wrong thread. */
+
+static thread_func yielder;
+static uint64_t measure_switch (int);
+
+void
+test_priority_switch (void) 
+{
+  uint64_t few_cycles, many_cycles;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Yielding %d times among %d threads, then among %d.",
+       SWITCH_CNT, FEW_THREADS, MANY_THREADS);
+  few_cycles = measure_switch (FEW_THREADS);
+  many_cycles = measure_switch (MANY_THREADS);
+
+  msg ("All threads took their turns in order.");
+  msg ("Average context switch with %d threads ready: %"PRIu64" cycles.",
+       FEW_THREADS, few_cycles);
+  msg ("Average context switch with %d threads ready: %"PRIu64" cycles.",
+       MANY_THREADS, many_cycles);
+}
+
+/* Has CNT threads yield SWITCH_CNT times between them and
+   returns the average number of cycles per switch. */
+static uint64_t
+measure_switch (int cnt) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* Keep the yielders from running until all of them exist. */
+  thread_set_priority (PRI_MAX);
+  thread_cnt = cnt;
+  yield_cnt = 0;
+  out_of_turn_cnt = 0;
+  for (i = 0; i < cnt; i++)
+    if (thread_create ("yielder", PRI_DEFAULT, yielder, (void *) (intptr_t) i)
+        == TID_ERROR)
+      fail ("couldn't create thread %d", i);
+
+  start = rdtsc ();
+  thread_set_priority (PRI_MIN);
+  cycles = rdtsc () - start;
+  thread_set_priority (PRI_DEFAULT);
+
+  if (yield_cnt != SWITCH_CNT)
+    fail ("%d yields instead of %d", yield_cnt, SWITCH_CNT);
+  if (out_of_turn_cnt != 0)
+    fail ("%d of %d yields among %d threads came out of turn",
+          out_of_turn_cnt, SWITCH_CNT, cnt);
+  return cycles / SWITCH_CNT;
+}
+
+static void
+yielder (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int i;
+
+  for (i = 0; i < SWITCH_CNT / thread_cnt; i++) 
+    {
+      if (yield_cnt++ % thread_cnt != id)
+        out_of_turn_cnt++;
+      thread_yield ();
+    }
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The two "Average context switch" lines carry cycle counts that
+# depend on the machine; they are there for people reading the
+# output, so leave them out of the comparison.
+compare_output ("run", [grep (!/Average context switch/, @output)], [<<'EOF']);
+(priority-switch) begin
+(priority-switch) Yielding 10000 times among 2 threads, then among 200.
+(priority-switch) All threads took their turns in order.
+(priority-switch) end
+EOF
+pass;
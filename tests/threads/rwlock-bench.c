@@ -0,0 +1,140 @@
+/* Compares an rwlock against a plain lock under contention.
+   Eight threads each enter a critical section a number of times,
+   as readers for the given fraction of entries and as writers for
+   the rest, and yield inside it so that the others pile up
+   waiting.  The average number of cycles per entry is reported for
+   both kinds of lock.
+
+   The workers also count who is inside the section.  A writer, or
+   anyone holding the plain lock, must be alone there, and with
+   nothing but readers all eight must get in together under the
+   rwlock, since each yields to the next while inside. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define THREAD_CNT 8
+#define ITERATIONS 100
+
+struct bench 
+  {
+    bool use_rwlock;            /* Use RW instead of LOCK. */
+    int read_pct;               /* Percentage of entries that read. */
+    struct lock lock;
+    struct rwlock rw;
+    struct semaphore done;      /* Upped by each finished worker. */
+    int inside;                 /* Threads in the critical section. */
+    int max_inside;             /* Most of them there at once. */
+    bool shared_write;          /* Did anyone join a writer? */
+  };
+
+static thread_func worker;
+static uint64_t run_bench (struct bench *, bool use_rwlock, int read_pct);
+
+void
+test_rwlock_bench (void) 
+{
+  static const int read_pcts[] = {100, 90, 50, 0};
+  struct bench b;
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d threads entering the critical section %d times each.",
+       THREAD_CNT, ITERATIONS);
+  for (i = 0; i < sizeof read_pcts / sizeof *read_pcts; i++)
+    {
+      uint64_t lock_cycles, rw_cycles;
+
+      lock_cycles = run_bench (&b, false, read_pcts[i]);
+      if (b.max_inside != 1)
+        fail ("%d threads held the plain lock at once", b.max_inside);
+
+      rw_cycles = run_bench (&b, true, read_pcts[i]);
+      if (b.shared_write)
+        fail ("a thread entered alongside a writer at %d%% reads",
+              read_pcts[i]);
+      if (read_pcts[i] == 100 && b.max_inside != THREAD_CNT)
+        fail ("only %d of %d readers shared the rwlock",
+              b.max_inside, THREAD_CNT);
+
+      msg ("%d%% reads: lock %"PRIu64" cycles/op, rwlock %"PRIu64" cycles/op.",
+           read_pcts[i], lock_cycles, rw_cycles);
+    }
+  msg ("Readers shared the rwlock; writers were always alone.");
+}
+
+/* Runs THREAD_CNT workers on B to completion and returns the
+   average number of cycles per critical section entry. */
+static uint64_t
+run_bench (struct bench *b, bool use_rwlock, int read_pct) 
+{
+  uint64_t start;
+  int i;
+
+  b->use_rwlock = use_rwlock;
+  b->read_pct = read_pct;
+  lock_init (&b->lock);
+  rwlock_init (&b->rw);
+  sema_init (&b->done, 0);
+  b->inside = b->max_inside = 0;
+  b->shared_write = false;
+
+  /* The workers have our priority, so none runs before we block. */
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker, b) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&b->done);
+  return (rdtsc () - start) / (THREAD_CNT * ITERATIONS);
+}
+
+static void
+worker (void *b_) 
+{
+  struct bench *b = b_;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      /* Spread the reads evenly over the iterations. */
+      bool read = (i * 37) % 100 < b->read_pct;
+      bool exclusive = !b->use_rwlock || !read;
+
+      if (!b->use_rwlock)
+        lock_acquire (&b->lock);
+      else if (read)
+        rwlock_read_acquire (&b->rw);
+      else
+        rwlock_write_acquire (&b->rw);
+
+      if (exclusive && b->inside != 0)
+        b->shared_write = true;
+      if (++b->inside > b->max_inside)
+        b->max_inside = b->inside;
+      thread_yield ();
+      if (exclusive && b->inside != 1)
+        b->shared_write = true;
+      b->inside--;
+
+      if (!b->use_rwlock)
+        lock_release (&b->lock);
+      else if (read)
+        rwlock_read_release (&b->rw);
+      else
+        rwlock_write_release (&b->rw);
+    }
+  sema_up (&b->done);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The test itself checks who was inside the critical section.  Each
+# read ratio adds a line of cycle counts, which vary with the machine;
+# make sure all four are there and compare the rest.
+my (@ratios) = map (/^\(rwlock-bench\) (\d+)% reads: lock \d+ cycles\/op, rwlock \d+ cycles\/op\.$/, @output);
+fail "expected measurements at 100, 90, 50 and 0% reads, got @ratios\n"
+  if "@ratios" ne "100 90 50 0";
+compare_output ("run", [grep (!/% reads:/, @output)], [<<'EOF']);
+(rwlock-bench) begin
+(rwlock-bench) 8 threads entering the critical section 100 times each.
+(rwlock-bench) Readers shared the rwlock; writers were always alone.
+(rwlock-bench) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Checks that a thread holding an rwlock shared can take it
+   shared again while a writer is waiting, as when a read
+   page-faults back into a read of the same inode.  The main
+   thread holds the lock shared, and a higher-priority writer
+   starts waiting for it and donates its priority.  The main
+   thread then takes the lock shared a second time, which must not
+   queue it behind the writer, and releases it twice.  The writer
+   must get the lock only on the second release. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+
+void
+test_rwlock_reenter (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_read_acquire (&rw);
+  msg ("Main thread holds the lock shared.");
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  rwlock_read_acquire (&rw);
+  msg ("Main thread took the lock shared again.");
+  rwlock_read_release (&rw);
+  msg ("Main thread released the lock once.");
+  rwlock_read_release (&rw);
+  msg ("Main thread released the lock twice.");
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("writer: waiting for the lock");
+  rwlock_write_acquire (rw);
+  msg ("writer: got the lock");
+  rwlock_write_release (rw);
+  msg ("writer: done");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-reenter) begin
+(rwlock-reenter) Main thread holds the lock shared.
+(rwlock-reenter) writer: waiting for the lock
+(rwlock-reenter) Main thread should have priority 32.  Actual priority: 32.
+(rwlock-reenter) Main thread took the lock shared again.
+(rwlock-reenter) Main thread released the lock once.
+(rwlock-reenter) writer: got the lock
+(rwlock-reenter) writer: done
+(rwlock-reenter) Main thread released the lock twice.
+(rwlock-reenter) Main thread should have priority 31.  Actual priority: 31.
+(rwlock-reenter) end
+EOF
+pass;
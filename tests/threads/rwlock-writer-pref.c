@@ -0,0 +1,62 @@
+/* Checks that an rwlock is shared among readers but that a
+   waiting writer keeps new readers out.  The main thread holds
+   the lock shared and a second reader gets in alongside it.  Then
+   a writer starts waiting, and a reader that arrives after it must
+   wait until the writer is done, even though the lock is still
+   only held shared when it arrives. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_writer_pref (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_read_acquire (&rw);
+  msg ("Main thread holds the lock shared.");
+  thread_create ("reader 0", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread_func, &rw);
+
+  /* Let reader 1 run and block behind the writer. */
+  thread_yield ();
+  msg ("Main thread releasing the lock.");
+  rwlock_read_release (&rw);
+  msg ("reader 0, writer, reader 1 must already have finished, in that order.");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_read_acquire (rw);
+  msg ("%s: got the lock shared", thread_name ());
+  rwlock_read_release (rw);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_write_acquire (rw);
+  msg ("writer: got the lock");
+  rwlock_write_release (rw);
+  msg ("writer: done");
+}
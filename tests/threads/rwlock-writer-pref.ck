@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) Main thread holds the lock shared.
+(rwlock-writer-pref) reader 0: got the lock shared
+(rwlock-writer-pref) reader 0: done
+(rwlock-writer-pref) Main thread releasing the lock.
+(rwlock-writer-pref) writer: got the lock
+(rwlock-writer-pref) writer: done
+(rwlock-writer-pref) reader 1: got the lock shared
+(rwlock-writer-pref) reader 1: done
+(rwlock-writer-pref) reader 0, writer, reader 1 must already have finished, in that order.
+(rwlock-writer-pref) end
+EOF
+pass;
@@ -0,0 +1,190 @@
+/* Checks memcpy(), memset() and memcmp() at every alignment of
+   source and destination and at lengths on both sides of the
+   points where they switch between bytes, words and `rep'
+   instructions.  Every result is compared byte by byte, and the
+   bytes just past each block must be left alone.
+
+   Then measures memcpy() and memset() on whole pages, the case
+   that fork, the VM and palloc hit most.  Each is timed over a
+   number of 4 kB copies or fills between two pages, next to a
+   plain byte-at-a-time loop that does the same work, and the
+   average number of cycles per page is reported for both.  The
+   cycle counts are only reported. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define ITERATIONS 1000
+#define BUF_PAGES 3             /* Room for the longest block plus offsets. */
+#define GUARD_CNT 16            /* Bytes checked past the end of each block. */
+#define GUARD_BYTE 0xff         /* Never appears in the source pattern. */
+#define FILL_BYTE 0x5a
+
+static const size_t sizes[] =
+  {
+    0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 255, 256, 257, 1000,
+    PGSIZE - 1, PGSIZE, PGSIZE + 1, 2 * PGSIZE,
+  };
+
+static void check_copy (uint8_t *, const uint8_t *, size_t, size_t, size_t);
+static void check_fill (uint8_t *, size_t, size_t);
+static void check_compare (uint8_t *, const uint8_t *,
+                           size_t, size_t, size_t);
+static void byte_copy (uint8_t *, const uint8_t *, size_t);
+static void byte_fill (uint8_t *, int, size_t);
+
+void
+test_string_bench (void) 
+{
+  uint8_t *src, *dst;
+  uint64_t start, byte_cycles, fast_cycles;
+  size_t dst_ofs, src_ofs, i;
+  int n;
+
+  src = palloc_get_multiple (0, BUF_PAGES);
+  dst = palloc_get_multiple (0, BUF_PAGES);
+  if (src == NULL || dst == NULL)
+    fail ("couldn't allocate pages");
+  for (i = 0; i < BUF_PAGES * PGSIZE; i++)
+    src[i] = i * 7 % 251;
+
+  for (dst_ofs = 0; dst_ofs < 8; dst_ofs++)
+    for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+      {
+        for (src_ofs = 0; src_ofs < 8; src_ofs++)
+          {
+            check_copy (dst, src, dst_ofs, src_ofs, sizes[i]);
+            check_compare (dst, src, dst_ofs, src_ofs, sizes[i]);
+          }
+        check_fill (dst, dst_ofs, sizes[i]);
+      }
+  msg ("memcpy, memset and memcmp agree with byte loops at every alignment.");
+
+  msg ("Copying and zeroing a page %d times each.", ITERATIONS);
+
+  start = rdtsc ();
+  for (n = 0; n < ITERATIONS; n++)
+    byte_copy (dst, src, PGSIZE);
+  byte_cycles = rdtsc () - start;
+  start = rdtsc ();
+  for (n = 0; n < ITERATIONS; n++)
+    memcpy (dst, src, PGSIZE);
+  fast_cycles = rdtsc () - start;
+  if (memcmp (dst, src, PGSIZE))
+    fail ("memcpy produced a different page");
+  msg ("4 kB copy: byte loop %"PRIu64" cycles, memcpy %"PRIu64" cycles.",
+       byte_cycles / ITERATIONS, fast_cycles / ITERATIONS);
+
+  start = rdtsc ();
+  for (n = 0; n < ITERATIONS; n++)
+    byte_fill (dst, 0, PGSIZE);
+  byte_cycles = rdtsc () - start;
+  start = rdtsc ();
+  for (n = 0; n < ITERATIONS; n++)
+    memset (dst, 0, PGSIZE);
+  fast_cycles = rdtsc () - start;
+  for (i = 0; i < PGSIZE; i++)
+    if (dst[i] != 0)
+      fail ("memset left byte %zu nonzero", i);
+  msg ("4 kB zero: byte loop %"PRIu64" cycles, memset %"PRIu64" cycles.",
+       byte_cycles / ITERATIONS, fast_cycles / ITERATIONS);
+
+  palloc_free_multiple (src, BUF_PAGES);
+  palloc_free_multiple (dst, BUF_PAGES);
+}
+
+/* Copies SIZE bytes from SRC + SRC_OFS to DST + DST_OFS with
+   memcpy() and checks them and the bytes around them. */
+static void
+check_copy (uint8_t *dst, const uint8_t *src,
+            size_t dst_ofs, size_t src_ofs, size_t size) 
+{
+  size_t i;
+
+  byte_fill (dst, GUARD_BYTE, dst_ofs + size + GUARD_CNT);
+  memcpy (dst + dst_ofs, src + src_ofs, size);
+  for (i = 0; i < dst_ofs + size + GUARD_CNT; i++)
+    {
+      int expected = (i >= dst_ofs && i < dst_ofs + size
+                      ? src[src_ofs + i - dst_ofs] : GUARD_BYTE);
+      if (dst[i] != expected)
+        fail ("memcpy of %zu bytes from offset %zu to offset %zu "
+              "got byte %zu wrong", size, src_ofs, dst_ofs, i);
+    }
+}
+
+/* Fills SIZE bytes at DST + DST_OFS with memset() and checks them
+   and the bytes around them. */
+static void
+check_fill (uint8_t *dst, size_t dst_ofs, size_t size) 
+{
+  size_t i;
+
+  byte_fill (dst, GUARD_BYTE, dst_ofs + size + GUARD_CNT);
+  memset (dst + dst_ofs, FILL_BYTE, size);
+  for (i = 0; i < dst_ofs + size + GUARD_CNT; i++)
+    {
+      int expected = (i >= dst_ofs && i < dst_ofs + size
+                      ? FILL_BYTE : GUARD_BYTE);
+      if (dst[i] != expected)
+        fail ("memset of %zu bytes at offset %zu got byte %zu wrong",
+              size, dst_ofs, i);
+    }
+}
+
+/* Compares the SIZE bytes that check_copy() just copied to
+   DST + DST_OFS with those at SRC + SRC_OFS, first as they are
+   and then with the first, middle and last byte made greater in
+   turn.  The guard bytes after the block differ from the source,
+   so looking past the end also shows up. */
+static void
+check_compare (uint8_t *dst, const uint8_t *src,
+               size_t dst_ofs, size_t src_ofs, size_t size) 
+{
+  const uint8_t *a = src + src_ofs;
+  uint8_t *b = dst + dst_ofs;
+  size_t pos[3];
+  int i;
+
+  if (memcmp (a, b, size) != 0)
+    fail ("memcmp of %zu equal bytes at offsets %zu and %zu "
+          "found a difference", size, src_ofs, dst_ofs);
+  if (size == 0)
+    return;
+
+  pos[0] = 0;
+  pos[1] = size / 2;
+  pos[2] = size - 1;
+  for (i = 0; i < 3; i++)
+    {
+      b[pos[i]]++;
+      if (memcmp (a, b, size) >= 0 || memcmp (b, a, size) <= 0)
+        fail ("memcmp of %zu bytes at offsets %zu and %zu "
+              "misordered a difference at byte %zu",
+              size, src_ofs, dst_ofs, pos[i]);
+      b[pos[i]]--;
+    }
+}
+
+/* Copies SIZE bytes from SRC to DST one at a time, the way the
+   old memcpy() did. */
+static void
+byte_copy (uint8_t *dst, const uint8_t *src, size_t size) 
+{
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+/* Sets SIZE bytes at DST to VALUE one at a time, the way the old
+   memset() did. */
+static void
+byte_fill (uint8_t *dst, int value, size_t size) 
+{
+  while (size-- > 0)
+    *dst++ = value;
+}
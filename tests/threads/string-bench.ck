@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The "4 kB copy" and "4 kB zero" lines carry cycle counts that
+# depend on the machine; they are there for people reading the
+# output, so leave them out of the comparison.
+compare_output ("run", [grep (!/4 kB (copy|zero):/, @output)], [<<'EOF']);
+(string-bench) begin
+(string-bench) memcpy, memset and memcmp agree with byte loops at every alignment.
+(string-bench) Copying and zeroing a page 1000 times each.
+(string-bench) end
+EOF
+pass;
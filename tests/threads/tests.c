@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stress", test_alarm_stress},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,10 +26,22 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
+    {"priority-donate-deep", test_priority_donate_deep},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"priority-switch", test_priority_switch},
+    {"rwlock-writer-pref", test_rwlock_writer_pref},
+    {"rwlock-reenter", test_rwlock_reenter},
+    {"rwlock-bench", test_rwlock_bench},
+    {"priority-sema-bench", test_priority_sema_bench},
+    {"priority-donate-bench", test_priority_donate_bench},
+    {"string-bench", test_string_bench},
+    {"palloc-bench", test_palloc_bench},
+    {"palloc-prezero", test_palloc_prezero},
+    {"malloc-bench", test_malloc_bench},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -233,6 +233,12 @@ static char **parse_options(char **argv) {
             user_page_limit = atoi(value);
         else if (!strcmp(name, "-threads-tests"))
             thread_tests = true;
+#endif
+#ifdef VM
+        else if (!strcmp(name, "-fa"))
+            fault_around_pages = atoi(value);
+        else if (!strcmp(name, "-sl"))
+            stack_limit_pages = atoi(value);
 #endif
         else
             PANIC("unknown option `%s' (use -h for help)", name);
@@ -328,6 +334,10 @@ static void usage(void) {
         "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
         "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+        "  -fa=COUNT          Map up to COUNT following pages on a lazy load fault.\n"
+        "  -sl=COUNT          Limit the user stack to COUNT pages.\n"
 #endif
     );
     power_off();
@@ -352,6 +362,7 @@ void power_off(void) {
 static void print_stats(void) {
     timer_print_stats();
     thread_print_stats();
+    palloc_print_stats();
 #ifdef FILESYS
     disk_print_stats();
 #endif
@@ -360,4 +371,7 @@ static void print_stats(void) {
 #ifdef USERPROG
     exception_print_stats();
 #endif
+#ifdef VM
+    vm_print_stats();
+#endif
 }
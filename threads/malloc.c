@@ -9,6 +9,7 @@
 
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -34,7 +35,16 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   The smallest MAGAZINE_CNT sizes are also cached per thread.
+   Each thread keeps a "magazine" of free blocks for each of
+   them, chained through the blocks, and malloc() and free()
+   use it without taking the descriptor's lock.  An empty
+   magazine is refilled with MAGAZINE_BATCH blocks under a
+   single lock acquisition, and a full one gives MAGAZINE_BATCH
+   blocks back the same way.  Blocks in a magazine still count
+   as in use in their arena. */
 
 /* Descriptor. */
 struct desc {
@@ -42,8 +52,13 @@ struct desc {
     size_t blocks_per_arena; /* Number of blocks in an arena. */
     struct list free_list;   /* List of free blocks. */
     struct lock lock;        /* Lock. */
+    long long lock_cnt;      /* Times LOCK was acquired. */
 };
 
+/** #Project 3: Malloc Magazine 한 번에 채우거나 비우는 블록 수와 magazine 최대 크기 */
+#define MAGAZINE_BATCH 16
+#define MAGAZINE_MAX (2 * MAGAZINE_BATCH)
+
 /* Magic number for detecting arena corruption. */
 #define ARENA_MAGIC 0x9a548eed
 
@@ -56,7 +71,10 @@ struct arena {
 
 /* Free block. */
 struct block {
-    struct list_elem free_elem; /* Free list element. */
+    union {
+        struct list_elem free_elem; /* Free list element. */
+        struct block *next;         /* Next block in a magazine. */
+    };
 };
 
 /* Our set of descriptors. */
@@ -65,6 +83,11 @@ static size_t desc_cnt;       /* Number of descriptors. */
 
 static struct arena *block_to_arena(struct block *);
 static struct block *arena_to_block(struct arena *, size_t idx);
+static struct block *desc_pop(struct desc *);
+static void desc_push(struct desc *, struct block *);
+static struct magazine *magazine_of(struct desc *);
+static bool magazine_refill(struct desc *, struct magazine *);
+static void magazine_drain(struct desc *, struct magazine *, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void malloc_init(void) {
@@ -78,6 +101,7 @@ void malloc_init(void) {
         list_init(&d->free_list);
         lock_init(&d->lock);
     }
+    ASSERT(desc_cnt >= MAGAZINE_CNT);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -112,33 +136,21 @@ void *malloc(size_t size) {
         return a + 1;
     }
 
-    lock_acquire(&d->lock);
-
-    /* If the free list is empty, create a new arena. */
-    if (list_empty(&d->free_list)) {
-        size_t i;
+    /** #Project 3: Malloc Magazine 작은 블록은 lock 없이 스레드의 magazine에서 꺼냄 */
+    if (d < descs + MAGAZINE_CNT) {
+        struct magazine *m = magazine_of(d);
 
-        /* Allocate a page. */
-        a = palloc_get_page(0);
-        if (a == NULL) {
-            lock_release(&d->lock);
+        if (m->cnt == 0 && !magazine_refill(d, m))
             return NULL;
-        }
-
-        /* Initialize arena and add its blocks to the free list. */
-        a->magic = ARENA_MAGIC;
-        a->desc = d;
-        a->free_cnt = d->blocks_per_arena;
-        for (i = 0; i < d->blocks_per_arena; i++) {
-            struct block *b = arena_to_block(a, i);
-            list_push_back(&d->free_list, &b->free_elem);
-        }
+        b = m->top;
+        m->top = b->next;
+        m->cnt--;
+        return b;
     }
 
-    /* Get a block from free list and return it. */
-    b = list_entry(list_pop_front(&d->free_list), struct block, free_elem);
-    a = block_to_arena(b);
-    a->free_cnt--;
+    lock_acquire(&d->lock);
+    d->lock_cnt++;
+    b = desc_pop(d);
     lock_release(&d->lock);
     return b;
 }
@@ -209,23 +221,20 @@ void free(void *p) {
             memset(b, 0xcc, d->block_size);
 #endif
 
-            lock_acquire(&d->lock);
+            /** #Project 3: Malloc Magazine 작은 블록은 스레드의 magazine에 넣고, 가득 차면 일부를 반환 */
+            if (d < descs + MAGAZINE_CNT) {
+                struct magazine *m = magazine_of(d);
 
-            /* Add block to free list. */
-            list_push_front(&d->free_list, &b->free_elem);
-
-            /* If the arena is now entirely unused, free it. */
-            if (++a->free_cnt >= d->blocks_per_arena) {
-                size_t i;
-
-                ASSERT(a->free_cnt == d->blocks_per_arena);
-                for (i = 0; i < d->blocks_per_arena; i++) {
-                    struct block *b = arena_to_block(a, i);
-                    list_remove(&b->free_elem);
-                }
-                palloc_free_page(a);
+                b->next = m->top;
+                m->top = b;
+                if (++m->cnt >= MAGAZINE_MAX)
+                    magazine_drain(d, m, MAGAZINE_BATCH);
+                return;
             }
 
+            lock_acquire(&d->lock);
+            d->lock_cnt++;
+            desc_push(d, b);
             lock_release(&d->lock);
         } else {
             /* It's a big block.  Free its pages. */
@@ -235,6 +244,144 @@ void free(void *p) {
     }
 }
 
+/** #Project 3: Malloc Magazine 현재 스레드가 캐시한 블록을 모두 descriptor에 반환.
+ *  스레드 구조체가 사라지기 전에 thread_exit()에서 호출 */
+void malloc_drain_magazines(void) {
+    size_t i;
+
+    for (i = 0; i < MAGAZINE_CNT; i++) {
+        struct magazine *m = magazine_of(&descs[i]);
+
+        if (m->cnt > 0)
+            magazine_drain(&descs[i], m, m->cnt);
+    }
+}
+
+/* Takes a free block from D's free list, creating a new arena if
+   the list is empty, and returns it.  Returns a null pointer if
+   memory is not available.  D's lock must be held. */
+static struct block *desc_pop(struct desc *d) {
+    struct block *b;
+    struct arena *a;
+
+    ASSERT(lock_held_by_current_thread(&d->lock));
+
+    /* If the free list is empty, create a new arena. */
+    if (list_empty(&d->free_list)) {
+        size_t i;
+
+        /* Allocate a page. */
+        a = palloc_get_page(0);
+        if (a == NULL)
+            return NULL;
+
+        /* Initialize arena and add its blocks to the free list. */
+        a->magic = ARENA_MAGIC;
+        a->desc = d;
+        a->free_cnt = d->blocks_per_arena;
+        for (i = 0; i < d->blocks_per_arena; i++) {
+            struct block *b = arena_to_block(a, i);
+            list_push_back(&d->free_list, &b->free_elem);
+        }
+    }
+
+    /* Get a block from free list and return it. */
+    b = list_entry(list_pop_front(&d->free_list), struct block, free_elem);
+    a = block_to_arena(b);
+    a->free_cnt--;
+    return b;
+}
+
+/* Returns block B to D's free list, giving its arena back to the
+   page allocator if that leaves the arena entirely unused.  D's
+   lock must be held. */
+static void desc_push(struct desc *d, struct block *b) {
+    struct arena *a = block_to_arena(b);
+
+    ASSERT(lock_held_by_current_thread(&d->lock));
+
+    /* Add block to free list. */
+    list_push_front(&d->free_list, &b->free_elem);
+
+    /* If the arena is now entirely unused, free it. */
+    if (++a->free_cnt >= d->blocks_per_arena) {
+        size_t i;
+
+        ASSERT(a->free_cnt == d->blocks_per_arena);
+        for (i = 0; i < d->blocks_per_arena; i++) {
+            struct block *b = arena_to_block(a, i);
+            list_remove(&b->free_elem);
+        }
+        palloc_free_page(a);
+    }
+}
+
+/* Returns the running thread's magazine for D.  Magazines are
+   only touched by their own thread, never by interrupt handlers,
+   so they need no locking. */
+static struct magazine *magazine_of(struct desc *d) {
+    ASSERT(!intr_context());
+    ASSERT(d >= descs && d < descs + MAGAZINE_CNT);
+    return &thread_current()->magazines[d - descs];
+}
+
+/* Moves up to MAGAZINE_BATCH blocks from D into empty magazine M.
+   Returns false if not even one block was available. */
+static bool magazine_refill(struct desc *d, struct magazine *m) {
+    size_t i;
+
+    lock_acquire(&d->lock);
+    d->lock_cnt++;
+    for (i = 0; i < MAGAZINE_BATCH; i++) {
+        struct block *b = desc_pop(d);
+
+        if (b == NULL)
+            break;
+        b->next = m->top;
+        m->top = b;
+        m->cnt++;
+    }
+    lock_release(&d->lock);
+    return m->cnt > 0;
+}
+
+/* Moves CNT blocks from magazine M back to D. */
+static void magazine_drain(struct desc *d, struct magazine *m, size_t cnt) {
+    ASSERT(cnt <= m->cnt);
+
+    lock_acquire(&d->lock);
+    d->lock_cnt++;
+    while (cnt-- > 0) {
+        struct block *b = m->top;
+
+        m->top = b->next;
+        m->cnt--;
+        desc_push(d, b);
+    }
+    lock_release(&d->lock);
+}
+
+/* Returns how many SIZE-byte blocks malloc() fits in one arena page,
+   or 0 if SIZE is too big for any descriptor. */
+size_t malloc_blocks_per_page(size_t size) {
+    struct desc *d;
+
+    for (d = descs; d < descs + desc_cnt; d++)
+        if (d->block_size >= size)
+            return d->blocks_per_arena;
+    return 0;
+}
+
+/** #Project 3: Malloc Magazine 부팅 이후 모든 descriptor의 lock을 잡은 횟수 */
+long long malloc_lock_acquisitions(void) {
+    long long cnt = 0;
+    size_t i;
+
+    for (i = 0; i < desc_cnt; i++)
+        cnt += descs[i].lock_cnt;
+    return cnt;
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *block_to_arena(struct block *b) {
     struct arena *a = pg_round_down(b);
@@ -3,6 +3,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -10,8 +11,8 @@
 #include <string.h>
 
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -26,23 +27,66 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are kept by a binary buddy allocator:
+   a free block of order K is 2**K pages starting at a page index
+   that is a multiple of 2**K, and sits on the pool's free list
+   for order K.  A request is rounded up to a power of two, taken
+   from the smallest order that has a block, split down as
+   needed, and the pages past the request are freed again at
+   once.  Freeing merges a block with its buddy for as long as the
+   buddy is free too, so both take O(log n) time.
+
+   A pool's free lists and pre-zeroed pages are protected by turning
+   interrupts off, not by a lock: palloc_free_page() is called from
+   the scheduler with interrupts already off, and the idle thread,
+   which keeps the pre-zeroed pages filled, must never sleep. */
+
+/** #Project 3: Pre-zeroed Pages 미리 0으로 채워 둘 수 있는 페이지 수의 상한 */
+#define ZEROED_MAX 64
+
+/** #Project 3: Buddy Allocator 블록 차수의 개수. 가장 큰 블록은 2**(ORDER_CNT - 1) 페이지 */
+#define ORDER_CNT 20
+
+/** #Project 3: Buddy Allocator order_map에서 free 블록의 첫 페이지 표시. 하위 비트는 차수 */
+#define FREE_HEAD 0x80
 
 /* A memory pool. */
 struct pool {
-    struct lock lock;        /* Mutual exclusion. */
     struct bitmap *used_map; /* Bitmap of free pages. */
     uint8_t *base;           /* Base of pool. */
+
+    /** #Project 3: Buddy Allocator */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    uint8_t *order_map;                 /* 페이지마다 FREE_HEAD | 차수, free 블록의 첫 페이지가 아니면 0 */
+    struct list free_lists[ORDER_CNT];  /* 차수별 free 블록. 원소는 블록의 첫 페이지에 있음 */
+    uint32_t free_mask;                 /* free 블록이 있는 차수의 비트맵 */
+
+    /** #Project 3: Pre-zeroed Pages 유휴 쓰레드가 미리 0으로 채운 페이지.
+     *  used_map에는 사용 중으로 표시되며, 페이지 내용이 0이어야 하므로 리스트 대신 배열에 보관.
+     *  유휴 쓰레드는 잠들 수 없으므로 lock 대신 인터럽트를 꺼서 보호 */
+    void *zeroed[ZEROED_MAX];
+    size_t zeroed_cnt;       /* Number of pages in ZEROED. */
+    size_t zeroed_max;       /* Pages the idle thread keeps in ZEROED. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/** #Project 3: Pre-zeroed Pages 통계 */
+static long long zero_req_cnt;   /* PAL_ZERO user page requests. */
+static long long zero_hit_cnt;   /* ...served from the pre-zeroed pages. */
+
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool(const struct pool *, void *page);
+static void *zeroed_pop(struct pool *);
+static void zeroed_drain(struct pool *);
+static size_t pool_take(struct pool *, size_t page_cnt);
+static void pool_release(struct pool *, size_t page_idx, size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -218,12 +262,12 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
             page_idx = pg_no(start) - pg_no(pool->base);
             if ((uint64_t)pool_end < end) {
                 page_cnt = ((uint64_t)pool_end - start) / PGSIZE;
-                bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                pool_release(pool, page_idx, page_cnt);
                 start = (uint64_t)pool_end;
                 goto split;
             } else {
                 page_cnt = ((uint64_t)end - start) / PGSIZE;
-                bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                pool_release(pool, page_idx, page_cnt);
             }
         }
     }
@@ -253,14 +297,29 @@ uint64_t palloc_init(void) {
    FLAGS, in which case the kernel panics. */
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
     struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-    lock_acquire(&pool->lock);
-    size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-    lock_release(&pool->lock);
     void *pages;
 
+    /** #Project 3: Pre-zeroed Pages 0으로 채운 한 페이지 요청은 미리 채워 둔 페이지에서 먼저 */
+    if ((flags & PAL_ZERO) && page_cnt == 1 && pool == &user_pool) {
+        zero_req_cnt++;
+        pages = zeroed_pop(pool);
+        if (pages != NULL) {
+            zero_hit_cnt++;
+            return pages;
+        }
+    }
+
+    size_t page_idx = pool_take(pool, page_cnt);
+    if (page_idx == BITMAP_ERROR && page_cnt > 1 && pool->zeroed_cnt > 0) {
+        /** #Project 3: Pre-zeroed Pages 미리 채워 둔 페이지가 연속된 공간을 막고 있을 수 있으므로 돌려놓고 재시도 */
+        zeroed_drain(pool);
+        page_idx = pool_take(pool, page_cnt);
+    }
+
     if (page_idx != BITMAP_ERROR)
         pages = pool->base + PGSIZE * page_idx;
+    else if (page_cnt == 1)
+        pages = zeroed_pop(pool);
     else
         pages = NULL;
 
@@ -308,7 +367,7 @@ void palloc_free_multiple(void *pages, size_t page_cnt) {
     memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
     ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
-    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+    pool_release(pool, page_idx, page_cnt);
 }
 
 /* Frees the page at PAGE. */
@@ -316,22 +375,184 @@ void palloc_free_page(void *page) {
     palloc_free_multiple(page, 1);
 }
 
+/** #Project 3: Pre-zeroed Pages 유휴 쓰레드가 인터럽트가 켜진 상태로 호출. user pool의 빈 페이지 하나를
+ *  0으로 채워 모아 둔다. 더 채울 수 없으면 false.
+ *  유휴 쓰레드는 ready 큐에 들어가지 않으므로 잠들거나 lock을 쥐면 안 된다. 페이지는 인터럽트만 끄고
+ *  pool_take로 꺼내고, 0으로 채우는 동안에는 인터럽트를 켜 둔다 */
+bool palloc_zero_idle(void) {
+    struct pool *pool = &user_pool;
+    size_t page_idx;
+    void *page;
+    enum intr_level old_level;
+
+    if (pool->zeroed_cnt >= pool->zeroed_max)
+        return false;
+    page_idx = pool_take(pool, 1);
+    if (page_idx == BITMAP_ERROR)
+        return false;
+
+    page = pool->base + PGSIZE * page_idx;
+    memset(page, 0, PGSIZE);
+
+    /* 채우는 쪽은 유휴 쓰레드뿐이므로 그 사이에 개수는 줄어들기만 함 */
+    old_level = intr_disable();
+    pool->zeroed[pool->zeroed_cnt++] = page;
+    intr_set_level(old_level);
+    return pool->zeroed_cnt < pool->zeroed_max;
+}
+
+/** #Project 3: Pre-zeroed Pages 통계 출력 */
+void palloc_print_stats(void) {
+    printf("Palloc: %lld of %lld zeroed user pages came pre-zeroed", zero_hit_cnt, zero_req_cnt);
+    if (zero_req_cnt > 0)
+        printf(" (%lld.%02lld%%)", zero_hit_cnt * 100 / zero_req_cnt, zero_hit_cnt * 10000 / zero_req_cnt % 100);
+    printf("\n");
+}
+
+/** #Project 3: Pre-zeroed Pages 미리 0으로 채운 페이지를 하나 꺼냄. 없으면 NULL */
+static void *zeroed_pop(struct pool *pool) {
+    enum intr_level old_level = intr_disable();
+    void *page = pool->zeroed_cnt > 0 ? pool->zeroed[--pool->zeroed_cnt] : NULL;
+    intr_set_level(old_level);
+    return page;
+}
+
+/** #Project 3: Pre-zeroed Pages 미리 0으로 채운 페이지를 모두 빈 페이지로 되돌림 */
+static void zeroed_drain(struct pool *pool) {
+    enum intr_level old_level = intr_disable();
+    while (pool->zeroed_cnt > 0) {
+        void *page = pool->zeroed[--pool->zeroed_cnt];
+        pool_release(pool, pg_no(page) - pg_no(pool->base), 1);
+    }
+    intr_set_level(old_level);
+}
+
+/** #Project 3: Buddy Allocator 남은 free 블록 중 가장 큰 블록의 페이지 수 */
+size_t palloc_largest_free(enum palloc_flags flags) {
+    struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+    uint32_t free_mask = pool->free_mask;
+
+    return free_mask != 0 ? (size_t)1 << (31 - __builtin_clz(free_mask)) : 0;
+}
+
+/** #Project 3: Buddy Allocator PAGE_IDX에서 시작하는 차수 ORDER의 블록을 free 리스트에 추가 */
+static void block_push(struct pool *pool, size_t page_idx, int order) {
+    struct list_elem *e = (struct list_elem *)(pool->base + PGSIZE * page_idx);
+
+    list_push_front(&pool->free_lists[order], e);
+    pool->order_map[page_idx] = FREE_HEAD | order;
+    pool->free_mask |= (uint32_t)1 << order;
+}
+
+/** #Project 3: Buddy Allocator PAGE_IDX에서 시작하는 차수 ORDER의 free 블록을 free 리스트에서 제거 */
+static void block_remove(struct pool *pool, size_t page_idx, int order) {
+    list_remove((struct list_elem *)(pool->base + PGSIZE * page_idx));
+    pool->order_map[page_idx] = 0;
+    if (list_empty(&pool->free_lists[order]))
+        pool->free_mask &= ~((uint32_t)1 << order);
+}
+
+/** #Project 3: Buddy Allocator 블록을 반환하면서 buddy도 free이면 합쳐 더 큰 블록으로 만든다 */
+static void block_free(struct pool *pool, size_t page_idx, int order) {
+    while (order + 1 < ORDER_CNT) {
+        size_t buddy = page_idx ^ ((size_t)1 << order);
+
+        if (buddy + ((size_t)1 << order) > pool->page_cnt || pool->order_map[buddy] != (FREE_HEAD | order))
+            break;
+        block_remove(pool, buddy, order);
+        if (buddy < page_idx)
+            page_idx = buddy;
+        order++;
+    }
+    block_push(pool, page_idx, order);
+}
+
+/** #Project 3: Buddy Allocator [PAGE_IDX, PAGE_IDX + PAGE_CNT) 범위를 정렬된 가장 큰 블록들로 나누어 반환 */
+static void free_blocks(struct pool *pool, size_t page_idx, size_t page_cnt) {
+    while (page_cnt > 0) {
+        int order = 0;
+
+        while (order + 1 < ORDER_CNT && page_idx % ((size_t)2 << order) == 0 && ((size_t)2 << order) <= page_cnt)
+            order++;
+        block_free(pool, page_idx, order);
+        page_idx += (size_t)1 << order;
+        page_cnt -= (size_t)1 << order;
+    }
+}
+
+/** #Project 3: Buddy Allocator PAGE_CNT개의 연속된 페이지를 할당하고 첫 페이지 번호를 반환. 없으면 BITMAP_ERROR.
+ *  palloc_free_page는 스케줄러 안에서 인터럽트를 끈 채로도 불리므로 free 리스트는 lock 대신 인터럽트로 보호 */
+static size_t pool_take(struct pool *pool, size_t page_cnt) {
+    int order = 0;
+
+    while (((size_t)1 << order) < page_cnt)
+        if (++order >= ORDER_CNT)
+            return BITMAP_ERROR;
+
+    enum intr_level old_level = intr_disable();
+
+    /* 요청을 담을 수 있는 가장 작은 차수의 블록 */
+    uint32_t avail = pool->free_mask & ~(((uint32_t)1 << order) - 1);
+    if (avail == 0) {
+        intr_set_level(old_level);
+        return BITMAP_ERROR;
+    }
+    int found = __builtin_ctz(avail);
+
+    struct list_elem *e = list_front(&pool->free_lists[found]);
+    size_t page_idx = pg_no(e) - pg_no(pool->base);
+    block_remove(pool, page_idx, found);
+
+    /* 남는 절반들은 free 리스트로 */
+    while (found > order) {
+        found--;
+        block_push(pool, page_idx + ((size_t)1 << found), found);
+    }
+
+    /* 2의 거듭제곱에 못 미치는 요청이면 뒷부분은 바로 반환 */
+    free_blocks(pool, page_idx + page_cnt, ((size_t)1 << order) - page_cnt);
+
+    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+    intr_set_level(old_level);
+    return page_idx;
+}
+
+/** #Project 3: Buddy Allocator PAGE_IDX부터 PAGE_CNT개의 페이지를 반환 */
+static void pool_release(struct pool *pool, size_t page_idx, size_t page_cnt) {
+    enum intr_level old_level = intr_disable();
+
+    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+    free_blocks(pool, page_idx, page_cnt);
+    intr_set_level(old_level);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
     /* We'll put the pool's used_map at its base.
        Calculate the space needed for the bitmap
-       and subtract it from the pool's size. */
+       and subtract it from the pool's size.  The buddy
+       allocator's order_map goes right after it. */
     uint64_t pgcnt = (end - start) / PGSIZE;
     size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+    size_t om_pages = DIV_ROUND_UP(pgcnt, PGSIZE) * PGSIZE;
 
-    lock_init(&p->lock);
     p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
     p->base = (void *)start;
 
+    /** #Project 3: Buddy Allocator 처음엔 free 블록 없음. populate_pools가 사용 가능한 범위를 반환 */
+    p->page_cnt = pgcnt;
+    p->order_map = (uint8_t *)*bm_base + bm_pages;
+    memset(p->order_map, 0, pgcnt);
+    for (int order = 0; order < ORDER_CNT; order++)
+        list_init(&p->free_lists[order]);
+    p->free_mask = 0;
+    p->zeroed_cnt = 0;
+    p->zeroed_max = pgcnt / 4 < ZEROED_MAX ? pgcnt / 4 : ZEROED_MAX;
+
     // Mark all to unusable.
     bitmap_set_all(p->used_map, true);
 
-    *bm_base += bm_pages;
+    *bm_base += bm_pages + om_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
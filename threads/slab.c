@@ -0,0 +1,182 @@
+#include "threads/slab.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Object caches.
+
+   malloc() rounds every request up to a power of 2, so a
+   structure that is a little larger than one wastes most of a
+   block, and the VM allocates such structures for every page it
+   touches.  A slab cache instead serves objects of one size.  It
+   carves pages from the page allocator, called "slabs", into
+   slots of exactly that size (rounded up to 8 bytes for
+   alignment) behind a small header, and keeps the slabs that
+   have a free slot on a list.  A freed object goes back on its
+   slab's free chain as is: objects are not constructed or
+   destroyed by the cache, so the caller initializes every field
+   it uses.
+
+   A slab whose objects are all free is returned to the page
+   allocator, unless it is the only slab with free slots left, so
+   that a cache hovering around a slab boundary does not allocate
+   and free the same page over and over. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Slab header, at the start of each slab page. */
+struct slab {
+    unsigned magic;           /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache; /* Owning cache. */
+    struct list_elem elem;    /* Element in cache's partial list. */
+    struct free_obj *free;    /* Chain of free slots. */
+    size_t in_use;            /* Slots in use. */
+};
+
+/* Free slot. */
+struct free_obj {
+    struct free_obj *next; /* Next free slot in the same slab. */
+};
+
+static struct slab *obj_to_slab(struct slab_cache *, void *);
+static struct slab *slab_create(struct slab_cache *);
+
+/* Initializes cache C for objects of OBJ_SIZE bytes. */
+void slab_cache_init(struct slab_cache *c, const char *name, size_t obj_size) {
+    c->name = name;
+    c->obj_size = ROUND_UP(obj_size < sizeof(struct free_obj) ? sizeof(struct free_obj) : obj_size, 8);
+    c->objs_per_slab = (PGSIZE - sizeof(struct slab)) / c->obj_size;
+    ASSERT(c->objs_per_slab > 0);
+    list_init(&c->partial);
+    lock_init(&c->lock);
+
+    c->alloc_cnt = 0;
+    c->in_use = c->peak_in_use = 0;
+    c->slab_cnt = c->peak_slab_cnt = 0;
+}
+
+/* Obtains and returns an uninitialized object from cache C.
+   Returns a null pointer if memory is not available. */
+void *slab_alloc(struct slab_cache *c) {
+    struct slab *s;
+    struct free_obj *o;
+
+    lock_acquire(&c->lock);
+
+    /* If no slab has a free slot, create a new slab. */
+    if (list_empty(&c->partial)) {
+        s = slab_create(c);
+        if (s == NULL) {
+            lock_release(&c->lock);
+            return NULL;
+        }
+        list_push_front(&c->partial, &s->elem);
+    }
+
+    /* Take a slot from the first slab with one, and drop the slab
+       from the list once it is full. */
+    s = list_entry(list_front(&c->partial), struct slab, elem);
+    o = s->free;
+    s->free = o->next;
+    if (++s->in_use == c->objs_per_slab)
+        list_remove(&s->elem);
+
+    c->alloc_cnt++;
+    if (++c->in_use > c->peak_in_use)
+        c->peak_in_use = c->in_use;
+
+    lock_release(&c->lock);
+    return o;
+}
+
+/* Returns object P, which must have been obtained from cache C
+   with slab_alloc(), to C. */
+void slab_free(struct slab_cache *c, void *p) {
+    struct slab *s;
+    struct free_obj *o = p;
+
+    if (p == NULL)
+        return;
+    s = obj_to_slab(c, p);
+
+#ifndef NDEBUG
+    /* Clear the object to help detect use-after-free bugs. */
+    memset(p, 0xcc, c->obj_size);
+#endif
+
+    lock_acquire(&c->lock);
+
+    /* A full slab has a free slot again. */
+    if (s->in_use-- == c->objs_per_slab)
+        list_push_front(&c->partial, &s->elem);
+    o->next = s->free;
+    s->free = o;
+    c->in_use--;
+
+    /* Give an entirely unused slab back, unless it is the last
+       one with free slots. */
+    if (s->in_use == 0 && list_front(&c->partial) != list_back(&c->partial)) {
+        list_remove(&s->elem);
+        s->magic = 0;
+        palloc_free_page(s);
+        c->slab_cnt--;
+    }
+
+    lock_release(&c->lock);
+}
+
+/* Prints statistics for cache C. */
+void slab_print_stats(struct slab_cache *c) {
+    printf("Slab %s: %zu-byte objects, %zu per slab, %lld allocated, peak %zu in use in %zu slabs\n",
+           c->name, c->obj_size, c->objs_per_slab, c->alloc_cnt, c->peak_in_use, c->peak_slab_cnt);
+}
+
+/* Returns the slab that object P from cache C is inside. */
+static struct slab *obj_to_slab(struct slab_cache *c, void *p) {
+    struct slab *s = pg_round_down(p);
+
+    /* Check that the slab is valid and belongs to C. */
+    ASSERT(s != NULL);
+    ASSERT(s->magic == SLAB_MAGIC);
+    ASSERT(s->cache == c);
+
+    /* Check that the object is properly aligned for the slab. */
+    ASSERT((pg_ofs(p) - sizeof *s) % c->obj_size == 0);
+
+    return s;
+}
+
+/* Allocates a slab page for cache C and chains all of its slots
+   onto the slab's free chain.  Returns a null pointer if memory
+   is not available.  C's lock must be held. */
+static struct slab *slab_create(struct slab_cache *c) {
+    struct slab *s;
+    size_t i;
+
+    ASSERT(lock_held_by_current_thread(&c->lock));
+
+    s = palloc_get_page(0);
+    if (s == NULL)
+        return NULL;
+
+    s->magic = SLAB_MAGIC;
+    s->cache = c;
+    s->free = NULL;
+    s->in_use = 0;
+    for (i = c->objs_per_slab; i-- > 0;) {
+        struct free_obj *o = (struct free_obj *)((uint8_t *)s + sizeof *s + i * c->obj_size);
+        o->next = s->free;
+        s->free = o;
+    }
+
+    if (++c->slab_cnt > c->peak_slab_cnt)
+        c->peak_slab_cnt = c->slab_cnt;
+    return s;
+}
@@ -34,6 +34,16 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+static bool waiter_less(const struct heap_elem *, const struct heap_elem *, void *);
+static bool cond_waiter_less(const struct heap_elem *, const struct heap_elem *, void *);
+static struct rw_hold *rw_hold_find(thread_t *, const struct rwlock *);
+
+/** #Priority Scheduling - Synchronization 같은 우선순위의 대기 쓰레드를 먼저 온 순서로 깨우기 위한 번호 */
+static uint64_t next_wait_seq;
+
+/** #Priority Scheduling - Synchronization 부팅 이후 세마포어 대기 쓰레드끼리 비교한 횟수 */
+static long long waiter_compare_cnt;
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -47,7 +57,7 @@ void sema_init(struct semaphore *sema, unsigned value) {
     ASSERT(sema != NULL);
 
     sema->value = value;
-    list_init(&sema->waiters);
+    heap_init(&sema->waiters, waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -59,6 +69,7 @@ void sema_init(struct semaphore *sema, unsigned value) {
    thread will probably turn interrupts back on. This is
    sema_down function. */
 void sema_down(struct semaphore *sema) {
+    thread_t *t = thread_current();
     enum intr_level old_level;
 
     ASSERT(sema != NULL);
@@ -66,9 +77,10 @@ void sema_down(struct semaphore *sema) {
 
     old_level = intr_disable();
     while (sema->value == 0) {
-        /** #Priority Scheduling - Synchronization sema_priority 순서대로 waiters에 삽입  */
-        list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_priority, NULL);
-        // list_push_back(&sema->waiters, &thread_current()->elem);
+        /** #Priority Scheduling - Synchronization 우선순위 힙에 삽입 */
+        t->blocked_sema = sema;
+        t->wait_seq = next_wait_seq++;
+        heap_push(&sema->waiters, &t->wait_elem);
         thread_block();
     }
     sema->value--;
@@ -107,10 +119,11 @@ void sema_up(struct semaphore *sema) {
     ASSERT(sema != NULL);
 
     old_level = intr_disable();
-    if (!list_empty(&sema->waiters)) {
-        /** #Priority Scheduling - Synchronization waiter list 정렬 */
-        list_sort(&sema->waiters, cmp_priority, NULL);
-        thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
+    if (!heap_empty(&sema->waiters)) {
+        /** #Priority Scheduling - Synchronization 우선순위가 가장 높은 쓰레드를 깨움 */
+        thread_t *t = heap_entry(heap_pop(&sema->waiters), thread_t, wait_elem);
+        t->blocked_sema = NULL;
+        thread_unblock(t);
     }
     sema->value++;
     test_max_priority();
@@ -181,11 +194,12 @@ void lock_acquire(struct lock *lock) {
     ASSERT(!intr_context());
     ASSERT(!lock_held_by_current_thread(lock));
 
-    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 wait를 하게 될 lock 포인터 저장 후 대기 리스트에 추가하고 priority donation 수행 */
+    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 wait를 하게 될 lock 포인터 저장 후 priority donation 수행.
+     *  기부와 lock 대기 힙 삽입 사이에 holder가 우선순위를 다시 계산하지 않도록 인터럽트를 끈 채로 진행 */
     thread_t *t = thread_current();
+    enum intr_level old_level = intr_disable();
     if (lock->holder != NULL) {
         t->wait_lock = lock;
-        list_push_back(&lock->holder->donations, &t->donation_elem);
         if (!thread_mlfqs)
             donate_priority();
     }
@@ -195,6 +209,8 @@ void lock_acquire(struct lock *lock) {
     /** #Priority Donation 기다리고 있던 lock 포인터 반환 후 holder 갱신 */
     t->wait_lock = NULL;
     lock->holder = t;
+    list_push_back(&t->held_locks, &lock->elem);
+    intr_set_level(old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -210,8 +226,10 @@ bool lock_try_acquire(struct lock *lock) {
     ASSERT(!lock_held_by_current_thread(lock));
 
     success = sema_try_down(&lock->semaphore);
-    if (success)
+    if (success) {
         lock->holder = thread_current();
+        list_push_back(&lock->holder->held_locks, &lock->elem);
+    }
     return success;
 }
 
@@ -223,12 +241,11 @@ void lock_release(struct lock *lock) {
     ASSERT(lock_held_by_current_thread(lock));
 
     lock->holder = NULL;
+    list_remove(&lock->elem);
 
-    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 현재 쓰레드 대기 리스트 및 priority 갱신  */
-    if (!thread_mlfqs) {
-        remove_with_lock(lock);
+    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 남은 lock의 기부자로 priority 갱신  */
+    if (!thread_mlfqs)
         refresh_priority();
-    }
 
     sema_up(&lock->semaphore);
 }
@@ -241,10 +258,12 @@ bool lock_held_by_current_thread(const struct lock *lock) {
     return lock->holder == thread_current();
 }
 
-/* One semaphore in a list. */
+/* One semaphore in a condition's waiter heap. */
 struct semaphore_elem {
-    struct list_elem elem;      /* List element. */
+    struct heap_elem elem;      /* Heap element. */
     struct semaphore semaphore; /* This semaphore. */
+    struct thread *thread;      /* Thread waiting on SEMAPHORE. */
+    uint64_t seq;               /* Order of arrival. */
 };
 
 /* Initializes condition variable COND.  A condition variable
@@ -253,7 +272,7 @@ struct semaphore_elem {
 void cond_init(struct condition *cond) {
     ASSERT(cond != NULL);
 
-    list_init(&cond->waiters);
+    heap_init(&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -278,6 +297,8 @@ void cond_init(struct condition *cond) {
    we need to sleep. */
 void cond_wait(struct condition *cond, struct lock *lock) {
     struct semaphore_elem waiter;
+    thread_t *t = thread_current();
+    enum intr_level old_level;
 
     ASSERT(cond != NULL);
     ASSERT(lock != NULL);
@@ -285,8 +306,16 @@ void cond_wait(struct condition *cond, struct lock *lock) {
     ASSERT(lock_held_by_current_thread(lock));
 
     sema_init(&waiter.semaphore, 0);
-    /** #Priority Scheduling - Synchronization sema_priority 순서대로 waiters에 삽입  */
-    list_insert_ordered(&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+    waiter.thread = t;
+
+    /** #Priority Scheduling - Synchronization 우선순위 힙에 삽입. lock_release에서 우선순위가 바뀌면 자리를 옮김 */
+    old_level = intr_disable();
+    waiter.seq = next_wait_seq++;
+    heap_push(&cond->waiters, &waiter.elem);
+    t->wait_cond = cond;
+    t->cond_elem = &waiter.elem;
+    intr_set_level(old_level);
+
     lock_release(lock);
     sema_down(&waiter.semaphore);
     lock_acquire(lock);
@@ -305,10 +334,14 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED) {
     ASSERT(!intr_context());
     ASSERT(lock_held_by_current_thread(lock));
 
-    if (!list_empty(&cond->waiters)) {
-        /** #Priority Scheduling - Synchronization sema_priority 순서대로 재정렬  */
-        list_sort(&cond->waiters, cmp_sem_priority, NULL);
-        sema_up(&list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)->semaphore);
+    if (!heap_empty(&cond->waiters)) {
+        /** #Priority Scheduling - Synchronization 우선순위가 가장 높은 waiter를 깨움 */
+        enum intr_level old_level = intr_disable();
+        struct semaphore_elem *waiter = heap_entry(heap_pop(&cond->waiters), struct semaphore_elem, elem);
+        waiter->thread->wait_cond = NULL;
+        intr_set_level(old_level);
+
+        sema_up(&waiter->semaphore);
     }
 }
 
@@ -322,29 +355,204 @@ void cond_broadcast(struct condition *cond, struct lock *lock) {
     ASSERT(cond != NULL);
     ASSERT(lock != NULL);
 
-    while (!list_empty(&cond->waiters))
+    while (!heap_empty(&cond->waiters))
         cond_signal(cond, lock);
 }
 
-/** #Priority Scheduling - Synchronization 첫 번째 인자의 우선순위가 두 번째 인자의 우선순위보다 높으면 1, 아니면 0을 반환 */
-bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-    struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
-    struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);
+/** #Priority Scheduling - Synchronization 대기 쓰레드 T의 우선순위를 PRIORITY로 바꾸고,
+ *  기다리고 있는 semaphore와 condition의 힙에서 자리를 옮김. 인터럽트가 꺼진 상태에서 호출 */
+void sema_update_priority(struct thread *t, int priority) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (t->blocked_sema != NULL)
+        heap_remove(&t->blocked_sema->waiters, &t->wait_elem);
+    if (t->wait_cond != NULL)
+        heap_remove(&t->wait_cond->waiters, t->cond_elem);
+
+    t->priority = priority;
+
+    if (t->blocked_sema != NULL)
+        heap_push(&t->blocked_sema->waiters, &t->wait_elem);
+    if (t->wait_cond != NULL)
+        heap_push(&t->wait_cond->waiters, t->cond_elem);
+}
+
+/** #Priority Scheduling - Synchronization 우선순위가 낮거나, 같으면 나중에 온 쓰레드가 작음 */
+static bool waiter_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    const thread_t *a = heap_entry(a_, thread_t, wait_elem);
+    const thread_t *b = heap_entry(b_, thread_t, wait_elem);
+
+    waiter_compare_cnt++;
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+    return a->wait_seq > b->wait_seq;
+}
+
+/** #Priority Scheduling - Synchronization 부팅 이후 waiter_less 가 불린 횟수 */
+long long sema_waiter_compares(void) {
+    return waiter_compare_cnt;
+}
+
+/** #Priority Scheduling - Synchronization condition waiter 비교. 기준은 waiter_less와 같음 */
+static bool cond_waiter_less(const struct heap_elem *a_, const struct heap_elem *b_, void *aux UNUSED) {
+    const struct semaphore_elem *a = heap_entry(a_, struct semaphore_elem, elem);
+    const struct semaphore_elem *b = heap_entry(b_, struct semaphore_elem, elem);
+
+    if (a->thread->priority != b->thread->priority)
+        return a->thread->priority < b->thread->priority;
+    return a->seq > b->seq;
+}
+
+/** #Project 1: Reader-Writer Lock */
+
+/* Initializes RW.  A reader-writer lock may be held by any number
+   of readers at once, or by a single writer.
+
+   Writers are preferred: a writer takes RW's gate lock before it
+   waits for the current readers to leave, and readers must pass
+   through the same gate, so readers that arrive after a writer
+   wait behind it instead of starving it.  Threads waiting on the
+   gate donate their priority to the writer through the ordinary
+   lock machinery, and a writer waiting for readers to leave
+   donates its priority to each of them. */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    lock_init(&rw->gate);
+    sema_init(&rw->drain, 0);
+    rw->drainer = NULL;
+    rw->readers = 0;
+    list_init(&rw->holders);
+}
+
+/* Acquires RW shared, sleeping while a writer holds it or is
+   waiting for it.  If the current thread already holds RW shared,
+   returns at once; each such call needs its own release.  The
+   current thread must not hold RW exclusively, and may hold at
+   most RW_HOLD_MAX different rwlocks shared.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_read_acquire(struct rwlock *rw) {
+    thread_t *t = thread_current();
+    struct rw_hold *h;
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    /** #Project 1: Reader-Writer Lock 이미 공유 모드로 보유 중이면 gate를 거치지 않음.
+     *  기다리는 writer 뒤에 서면 writer는 이 쓰레드가 빠지기를, 이 쓰레드는 writer를 기다려 교착 */
+    h = rw_hold_find(t, rw);
+    if (h != NULL) {
+        h->depth++;
+        return;
+    }
+    ASSERT(!lock_held_by_current_thread(&rw->gate));
+
+    lock_acquire(&rw->gate);
+
+    /** #Project 1: Reader-Writer Lock writer가 찾아서 기부할 수 있도록 보유 기록. 기록 없이 보유하면
+     *  기부도, 중첩 보유 확인도 할 수 없으므로 슬롯이 없으면 패닉 */
+    h = rw_hold_find(t, NULL);
+    if (h == NULL)
+        PANIC("thread %s holds more than %d rwlocks shared", t->name, RW_HOLD_MAX);
+
+    old_level = intr_disable();
+    rw->readers++;
+    h->rw = rw;
+    h->thread = t;
+    h->depth = 0;
+    list_push_back(&rw->holders, &h->elem);
+    intr_set_level(old_level);
+
+    lock_release(&rw->gate);
+}
+
+/* Releases RW, which the current thread must hold shared.  The
+   last reader to leave wakes a writer waiting for it. */
+void rwlock_read_release(struct rwlock *rw) {
+    thread_t *t = thread_current();
+    struct rw_hold *h;
+    enum intr_level old_level;
 
-    if (sema_a == NULL || sema_b == NULL)
-        return false;
+    ASSERT(rw != NULL);
+    ASSERT(rw->readers > 0);
 
-    struct list *list_a = &(sema_a->semaphore.waiters);
-    struct list *list_b = &(sema_b->semaphore.waiters);
+    h = rw_hold_find(t, rw);
+    ASSERT(h != NULL);
+    if (h->depth > 0) {
+        h->depth--;
+        return;
+    }
 
-    if (list_a == NULL || list_b == NULL)
-        return false;
+    old_level = intr_disable();
+    list_remove(&h->elem);
+    h->rw = NULL;
+    if (--rw->readers == 0 && rw->drainer != NULL)
+        sema_up(&rw->drain);
+    intr_set_level(old_level);
 
-    thread_t *thread_a = list_entry(list_begin(list_a), thread_t, elem);
-    thread_t *thread_b = list_entry(list_begin(list_b), thread_t, elem);
+    /** #Project 1: Reader-Writer Lock writer에게 받은 기부 반환 */
+    if (!thread_mlfqs) {
+        refresh_priority();
+        test_max_priority();
+    }
+}
 
-    if (thread_a == NULL || thread_b == NULL)
-        return false;
+/* Acquires RW exclusively, sleeping until no other thread holds
+   it.  The current thread must not already hold RW, shared or
+   exclusively.
 
-    return thread_a->priority > thread_b->priority;
-}
\ No newline at end of file
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_write_acquire(struct rwlock *rw) {
+    thread_t *t = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+    ASSERT(rw_hold_find(t, rw) == NULL);
+
+    lock_acquire(&rw->gate);
+
+    old_level = intr_disable();
+    if (rw->readers > 0) {
+        /** #Project 1: Reader-Writer Lock reader가 모두 빠질 때까지 기다리며 reader들에게 priority donation */
+        rw->drainer = t;
+        t->wait_rwlock = rw;
+        if (!thread_mlfqs)
+            donate_priority();
+        sema_down(&rw->drain);
+        t->wait_rwlock = NULL;
+        rw->drainer = NULL;
+    }
+    intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold exclusively. */
+void rwlock_write_release(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(rwlock_write_held_by_current_thread(rw));
+
+    lock_release(&rw->gate);
+}
+
+/* Returns T's record of holding RW shared, or a free record if RW
+   is a null pointer, or a null pointer if there is none.  Only T
+   changes its records, so T may look without disabling
+   interrupts. */
+static struct rw_hold *rw_hold_find(thread_t *t, const struct rwlock *rw) {
+    for (int i = 0; i < RW_HOLD_MAX; i++)
+        if (t->read_holds[i].rw == rw)
+            return &t->read_holds[i];
+    return NULL;
+}
+
+/* Returns true if the current thread holds RW exclusively, false
+   otherwise. */
+bool rwlock_write_held_by_current_thread(const struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    return lock_held_by_current_thread(&rw->gate) && rw->readers == 0;
+}
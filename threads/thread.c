@@ -1,11 +1,13 @@
 #include "threads/thread.h"
 
 #include <debug.h>
+#include <inttypes.h>
 #include <random.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "threads/fixed_point.h"
 #include "threads/flags.h"
@@ -28,15 +30,56 @@
 #define THREAD_BASIC 0xd42df210
 
 /** #Project 1: Alarm Clock 전역 변수 */
-static struct list sleep_list;
-static int64_t next_tick_to_awake;
-
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/** #Project 1: Advanced Scheduler */
-static struct list all_list;
+/* Sleeping threads live on a hierarchical timing wheel.  Level L has
+   WHEEL_SLOTS slots of WHEEL_SLOTS^L ticks each; a thread sits on the
+   lowest level whose span covers its remaining sleep.  Every tick the
+   current level-0 slot is woken in full, and whenever a level's index
+   wraps to 0 the next level's current slot is cascaded down one level.
+   Each thread is thus touched at most WHEEL_LEVELS times between sleep
+   and wakeup, so a tick costs O(1) amortized however many threads
+   sleep. */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_SPAN ((int64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))  // 한 번에 담을 수 있는 최대 대기 틱
+
+static struct list sleep_wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static int64_t wheel_tick;  // 타이밍 휠이 마지막으로 처리한 틱
+static size_t sleeper_cnt;  // 휠 위의 쓰레드 수
+static long long wheel_move_cnt;  // 상위 레벨에서 아래로 옮겨진 횟수
+
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO queue
+   per priority; bit P of READY_MASK is set iff READY_QUEUES[P] is
+   non-empty, so finding the highest ready priority is a single
+   bit scan. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static size_t ready_cnt;  // ready 상태인 쓰레드 수 (load_avg 계산용)
+
+/** #Project 1: Priority Donation 부팅 이후 refresh_priority 가 살펴본 보유 lock 수 */
+static long long donation_scan_cnt;
+
+/** #Project 1: Advanced Scheduler recent_cpu 지연 감쇠
+   recent_cpu decays once a second for every thread, but only ready
+   and running threads take part in scheduling, so only they are
+   decayed on the second boundary.  Every thread records the epoch
+   (count of decays so far) its recent_cpu is current for; a blocked
+   thread catches up on the decays it missed when it is next woken
+   or queried, using the coefficients kept in DECAY_COEF.  A thread
+   still blocked when the oldest coefficient it needs is about to
+   be overwritten catches up then, so every decay uses its own
+   coefficient. */
+#define DECAY_HISTORY 64
+static int decay_coef[DECAY_HISTORY];  // epoch E 의 감쇠 계수는 decay_coef[E % DECAY_HISTORY]
+static int decay_epoch;
+static struct list stale_list;  // 감쇠가 밀린 block 쓰레드, block 된 순서(= recent_cpu_epoch 순)
+
+/** #Project 1: Advanced Scheduler 타이머 인터럽트에서 MLFQS 갱신에 쓴 시간 */
+static long long mlfqs_update_cnt;
+static uint64_t mlfqs_cycles;
+static uint64_t mlfqs_cycles_max;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -72,6 +115,10 @@ static void kernel_thread(thread_func *, void *aux);
 static void idle(void *aux UNUSED);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
+static void ready_push(thread_t *t);
+static thread_t *ready_pop(void);
+static int ready_max_priority(void);
+static void thread_update_priority(thread_t *t, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
@@ -112,14 +159,15 @@ void thread_init(void) {
 
     /* Init the globla thread context */
     lock_init(&tid_lock);
-    list_init(&ready_list);
+    for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+        list_init(&ready_queues[pri]);
     list_init(&destruction_req);
+    list_init(&stale_list);
 
-    /** #Project 1: Alarm Clock sleep list 초기화 */
-    list_init(&sleep_list);
-
-    /** #Project 1: Advanced Scheduler all list 초기화 */
-    list_init(&all_list);
+    /** #Project 1: Alarm Clock 타이밍 휠 초기화 */
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+            list_init(&sleep_wheel[level][slot]);
 
     /* Set up a thread structure for the running thread. */
     initial_thread = running_thread();
@@ -170,6 +218,9 @@ void thread_tick(void) {
 /* Prints thread statistics. */
 void thread_print_stats(void) {
     printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks, user_ticks);
+    if (thread_mlfqs && mlfqs_update_cnt > 0)
+        printf("Thread: MLFQS updates took %" PRIu64 " cycles over %lld ticks (worst %" PRIu64 ")\n", mlfqs_cycles,
+               mlfqs_update_cnt, mlfqs_cycles_max);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -246,9 +297,19 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
    is usually a better idea to use one of the synchronization
    primitives in synch.h. */
 void thread_block(void) {
+    thread_t *t = thread_current();
+
     ASSERT(!intr_context());
     ASSERT(intr_get_level() == INTR_OFF);
-    thread_current()->status = THREAD_BLOCKED;
+
+    /** #Project 1: Advanced Scheduler 자는 동안 필요한 감쇠 계수가 덮이기 전에 따라잡을 수 있도록 줄을 세움 */
+    if (thread_mlfqs && t != idle_thread) {
+        mlfqs_recent_cpu(t);
+        list_push_back(&stale_list, &t->stale_elem);
+        t->stale = true;
+    }
+
+    t->status = THREAD_BLOCKED;
     schedule();
 }
 
@@ -268,9 +329,17 @@ void thread_unblock(struct thread *t) {
     old_level = intr_disable();
     ASSERT(t->status == THREAD_BLOCKED);
 
-    /** #Project 1: Priority Scheduling 우선순위 순으로 정렬되어 list에 삽입 */
-    list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
-    // list_push_back(&ready_list, &t->elem);
+    /** #Project 1: Advanced Scheduler 자는 동안 놓친 감쇠를 반영한 우선순위로 큐에 들어감 */
+    if (thread_mlfqs) {
+        if (t->stale) {
+            list_remove(&t->stale_elem);
+            t->stale = false;
+        }
+        mlfqs_priority(t);
+    }
+
+    /** #Project 1: Priority Scheduling 우선순위 큐의 끝에 삽입 */
+    ready_push(t);
     t->status = THREAD_READY;
     intr_set_level(old_level);
 }
@@ -309,9 +378,8 @@ void thread_exit(void) {
 #ifdef USERPROG
     process_exit();
 #endif
-    /** #Project 1: Advanced Scheduler 스레드 종료 시 all_list에서 제거 */
-    if (thread_mlfqs)
-        list_remove(&thread_current()->all_elem);
+    /** #Project 3: Malloc Magazine 스레드 구조체와 함께 사라지기 전에 캐시한 블록을 돌려놓음 */
+    malloc_drain_magazines();
 
     /* 상태를 죽어가는 것으로 설정하고 다른 프로세스를 예약
        이 쓰레드는 Schedule_tail()을 호출하는 동안 파괴됨 */
@@ -330,9 +398,8 @@ void thread_yield(void) {
 
     old_level = intr_disable();
     if (curr != idle_thread)
-        /** #Project 1: Priority Scheduling 우선순위 순으로 정렬되어 list에 삽입 */
-        list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
-    // list_push_back(&ready_list, &curr->elem);
+        /** #Project 1: Priority Scheduling 우선순위 큐의 끝에 삽입 */
+        ready_push(curr);
     do_schedule(THREAD_READY);
     intr_set_level(old_level);
 }
@@ -394,6 +461,7 @@ int thread_get_recent_cpu(void) {
     thread_t *t = thread_current();
 
     enum intr_level old_level = intr_disable();
+    mlfqs_recent_cpu(t);
     int recent_cpu = fp_to_int_round(mult_mixed(t->recent_cpu, 100));  // 출력시 소수 2번째 자리까지 출력하기 위함
     intr_set_level(old_level);
 
@@ -420,6 +488,15 @@ static void idle(void *idle_started_ UNUSED) {
         intr_disable();
         thread_block();
 
+        /** #Project 3: Pre-zeroed Pages 할 일이 없는 동안 user pool의 빈 페이지를 한 장씩 미리 0으로 채움.
+         *  인터럽트를 켠 채로 진행하고, 페이지마다 ready 쓰레드가 생겼는지 확인해 바로 양보한다 */
+        intr_enable();
+        while (ready_cnt == 0 && palloc_zero_idle())
+            continue;
+        intr_disable();
+        if (ready_cnt != 0)
+            continue;
+
         /* Re-enable interrupts and wait for the next one.
 
            The `sti' instruction disables interrupts until the
@@ -459,15 +536,16 @@ static void init_thread(struct thread *t, const char *name, int priority) {
 
     if (thread_mlfqs) {
         /** #Project 1: Advanced Scheduler 자료구조 초기화 */
+        t->recent_cpu_epoch = decay_epoch;
         mlfqs_priority(t);
-        list_push_back(&all_list, &t->all_elem);
     } else {
         /** #Project 1: Priority Donation 자료구조 초기화 */
         t->priority = priority;
     }
 
     t->wait_lock = NULL;
-    list_init(&t->donations);
+    list_init(&t->held_locks);
+    t->wait_rwlock = NULL;
 
     t->magic = THREAD_MAGIC;
 
@@ -494,10 +572,10 @@ static void init_thread(struct thread *t, const char *name, int priority) {
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. */
 static struct thread *next_thread_to_run(void) {
-    if (list_empty(&ready_list))
+    if (ready_mask == 0)
         return idle_thread;
     else
-        return list_entry(list_pop_front(&ready_list), struct thread, elem);
+        return ready_pop();
 }
 
 /* Use iretq to launch the thread *** 실제로 context switching을 하는 함수 *** */
@@ -666,6 +744,56 @@ static tid_t allocate_tid(void) {
     return tid;
 }
 
+/** #Project 1: Alarm Clock 쓰레드를 남은 대기 시간에 맞는 휠 슬롯에 삽입
+ *  BASE 는 아직 처리되지 않은 가장 이른 틱. 인터럽트가 꺼진 상태에서 호출해야 함 */
+static void wheel_insert(thread_t *t, int64_t base) {
+    int64_t expires = t->wakeup_tick;
+    int level;
+
+    /* Deadlines already due go to BASE's slot; deadlines past the
+       wheel's reach are parked in its farthest slot and re-filed each
+       time that slot cascades. */
+    if (expires < base)
+        expires = base;
+    else if (expires - base >= WHEEL_SPAN)
+        expires = base + WHEEL_SPAN - 1;
+
+    for (level = 0; level < WHEEL_LEVELS - 1; level++)
+        if (expires - base < (int64_t)1 << (WHEEL_BITS * (level + 1)))
+            break;
+
+    list_push_back(&sleep_wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK], &t->elem);
+}
+
+/** #Project 1: Alarm Clock 휠을 한 틱 진행시키고 만료된 쓰레드를 깨움 */
+static void wheel_advance(void) {
+    int level;
+    int64_t now = ++wheel_tick;
+
+    /* Cascade every level whose lower neighbour just wrapped around. */
+    for (level = 1; level < WHEEL_LEVELS; level++) {
+        if ((now >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK)
+            break;
+
+        /* Everything here expires within this level's slot width of
+           NOW, so it is always refiled into a lower level. */
+        struct list *slot = &sleep_wheel[level][(now >> (WHEEL_BITS * level)) & WHEEL_MASK];
+        while (!list_empty(slot)) {
+            wheel_insert(list_entry(list_pop_front(slot), thread_t, elem), now);
+            wheel_move_cnt++;
+        }
+    }
+
+    struct list *due = &sleep_wheel[0][now & WHEEL_MASK];
+    while (!list_empty(due)) {
+        thread_t *th = list_entry(list_pop_front(due), thread_t, elem);
+
+        ASSERT(th->wakeup_tick <= now);
+        sleeper_cnt--;
+        thread_unblock(th);
+    }
+}
+
 /** #Project 1: Alarm Clock 쓰레드 비활성화 함수 */
 void thread_sleep(int64_t ticks) {
     thread_t *curr = thread_current();
@@ -676,53 +804,88 @@ void thread_sleep(int64_t ticks) {
         enum intr_level old_level;
         old_level = intr_disable();  // pause interrupt
 
-        update_next_tick_to_awake(curr->wakeup_tick = ticks);  // update awake ticks
-
-        list_push_back(&sleep_list, &curr->elem);  // push to sleep_list
+        curr->wakeup_tick = ticks;           // update awake ticks
+        wheel_insert(curr, wheel_tick + 1);  // push to sleep wheel
+        sleeper_cnt++;
 
         thread_block();  // block this thread
 
         intr_set_level(old_level);  // continue interrupt
     }
 }
-/** #Project 1: Alarm Clock 쓰레드 활성화 함수 */
+
+/** #Project 1: Alarm Clock 쓰레드 활성화 함수
+ *  타이머 인터럽트마다 호출되며 WAKEUP_TICK 까지 휠을 진행시킴 */
 void thread_awake(int64_t wakeup_tick) {
-    next_tick_to_awake = INT64_MAX;
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    /* With nobody asleep the slots are empty: just catch up the clock. */
+    if (sleeper_cnt == 0) {
+        wheel_tick = wakeup_tick;
+        return;
+    }
 
-    struct list_elem *sleeping = list_begin(&sleep_list);  // take sleeping thread
-    thread_t *th;
+    while (wheel_tick < wakeup_tick)
+        wheel_advance();
+}
 
-    while (sleeping != list_end(&sleep_list)) {  // for all sleeping threads
-        th = list_entry(sleeping, thread_t, elem);
+/** #Project 1: Alarm Clock 부팅 이후 cascade 로 다른 슬롯에 다시 넣은 쓰레드 수 */
+long long thread_wheel_moves(void) {
+    enum intr_level old_level = intr_disable();
+    long long moves = wheel_move_cnt;
+    intr_set_level(old_level);
+    return moves;
+}
 
-        if (wakeup_tick >= th->wakeup_tick) {
-            sleeping = list_remove(&th->elem);  // delete thread
-            thread_unblock(th);                 // unblock thread
-        } else {
-            update_next_tick_to_awake(th->wakeup_tick);  // update wakeup_tick
-            sleeping = list_next(sleeping);              // move to next sleeping thread
-        }
-    }
+/** #Project 1: Priority Scheduling T를 자신의 우선순위 큐 끝에 삽입. 인터럽트가 꺼진 상태에서 호출 */
+static void ready_push(thread_t *t) {
+    list_push_back(&ready_queues[t->priority], &t->elem);
+    ready_mask |= (uint64_t)1 << t->priority;
+    ready_cnt++;
 }
 
-/** #Project 1: Alarm Clock 다음 활성화 tick 갱신 함수 */
-void update_next_tick_to_awake(int64_t ticks) {
-    next_tick_to_awake = (next_tick_to_awake > ticks) ? ticks : next_tick_to_awake;
+/** #Project 1: Priority Scheduling ready 상태인 T를 우선순위 큐에서 제거 */
+static void ready_remove(thread_t *t) {
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[t->priority]))
+        ready_mask &= ~((uint64_t)1 << t->priority);
+    ready_cnt--;
 }
 
-/** #Project 1: Alarm Clock 현재 next_tick_to_awake 값 리턴 함수 */
-int64_t get_next_tick_to_awake(void) {
-    return next_tick_to_awake;
+/** #Project 1: Priority Scheduling ready 상태 쓰레드 중 가장 높은 우선순위, 없으면 PRI_MIN - 1 */
+static int ready_max_priority(void) {
+    if (ready_mask == 0)
+        return PRI_MIN - 1;
+    return 63 - __builtin_clzll(ready_mask);
 }
 
-/** #Project 1: Priority Scheduling ready_list에서 우선 순위가 가장 높은 쓰레드와 현재 쓰레드의 우선 순위를 비교 */
-void test_max_priority(void) {
-    if (list_empty(&ready_list))
+/** #Project 1: Priority Scheduling 가장 높은 우선순위 큐의 맨 앞 쓰레드를 꺼냄 */
+static thread_t *ready_pop(void) {
+    thread_t *t = list_entry(list_front(&ready_queues[ready_max_priority()]), thread_t, elem);
+
+    ready_remove(t);
+    return t;
+}
+
+/** #Project 1: Priority Scheduling T의 우선순위를 PRIORITY로 바꾸고, ready 상태라면 맞는 큐로,
+ *  semaphore나 condition을 기다리고 있다면 대기 힙의 맞는 자리로 옮김. 인터럽트가 꺼진 상태에서 호출 */
+static void thread_update_priority(thread_t *t, int priority) {
+    if (t->priority == priority)
         return;
 
-    thread_t *th = list_entry(list_front(&ready_list), thread_t, elem);
+    if (t->status == THREAD_READY) {
+        ready_remove(t);
+        t->priority = priority;
+        ready_push(t);
+    } else if (t->blocked_sema != NULL || t->wait_cond != NULL)
+        sema_update_priority(t, priority);
+    else
+        t->priority = priority;
+}
 
-    if (thread_current()->priority < th->priority) {
+/** #Project 1: Priority Scheduling ready 큐에서 우선 순위가 가장 높은 쓰레드와 현재 쓰레드의 우선 순위를 비교 */
+void test_max_priority(void) {
+    if (thread_current()->priority < ready_max_priority()) {
         /** Project 2: Panic 방지 */
         if (intr_context())
             intr_yield_on_return();
@@ -731,67 +894,81 @@ void test_max_priority(void) {
     }
 }
 
-/** #Project 1: Priority Scheduling 첫번째 인자의 우선순위가 높으면 1, 아니면 0 */
-bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-    thread_t *thread_a = list_entry(a, thread_t, elem);
-    thread_t *thread_b = list_entry(b, thread_t, elem);
-
-    if (thread_a == NULL || thread_b == NULL)
-        return false;
+/** #Project 1: Priority Donation T가 기다리고 있는 lock의 holder, 또는 rwlock의 reader 전부에게 PRIORITY를
+ *  기부한다. 기부로 우선순위가 실제로 올라간 쓰레드에 대해서만 그 쓰레드가 기다리는 대상으로 계속 전파하며
+ *  깊이 제한은 없다. 대기자의 우선순위는 항상 holder 이하이므로 이미 PRIORITY 이상인 holder에서 멈춰도
+ *  그 위쪽은 이미 PRIORITY 이상이다. lock 체인은 반복문으로, reader가 여럿인 rwlock만 재귀로 따라간다.
+ *  인터럽트가 꺼진 상태에서 호출 */
+static void donate_to_holders(thread_t *t, int priority) {
+    while (t->wait_lock != NULL) {
+        thread_t *holder = t->wait_lock->holder;
+        if (holder == NULL || holder->priority >= priority)
+            return;
+
+        thread_update_priority(holder, priority);
+        t = holder;
+    }
 
-    return thread_a->priority > thread_b->priority;
+    if (t->wait_rwlock != NULL) {
+        struct list *holders = &t->wait_rwlock->holders;
+        for (struct list_elem *e = list_begin(holders); e != list_end(holders); e = list_next(e)) {
+            thread_t *reader = list_entry(e, struct rw_hold, elem)->thread;
+            if (reader->priority < priority) {
+                thread_update_priority(reader, priority);
+                donate_to_holders(reader, priority);
+            }
+        }
+    }
 }
 
 /** #Project 1: Priority Donation 현재 쓰레드가 기다리고 있는 lock과 연결된 모든 쓰레드들을 순회하며
  *  현재 쓰레드의 우선순위를 lock을 보유하고 있는 쓰레드에게 기부한다. */
 void donate_priority() {
     thread_t *t = thread_current();
-    int priority = t->priority;
-
-    for (int depth = 0; depth < 8; depth++) {
-        if (t->wait_lock == NULL)
-            break;
-
-        t = t->wait_lock->holder;
-        t->priority = priority;
-    }
-}
-
-/** #Project 1: Priority Donation 현재 쓰레드의 waiters 리스트를 확인하여 해지할 lock을 보유하고 있는
- *  엔트리를 삭제한다. */
-void remove_with_lock(struct lock *lock) {
-    thread_t *t = thread_current();
-    struct list_elem *curr = list_begin(&t->donations);
-    thread_t *curr_thread = NULL;
+    enum intr_level old_level = intr_disable();  // ready 큐를 옮길 수 있으므로
 
-    while (curr != list_end(&t->donations)) {
-        curr_thread = list_entry(curr, thread_t, donation_elem);
-
-        if (curr_thread->wait_lock == lock)
-            list_remove(&curr_thread->donation_elem);
-
-        curr = list_next(curr);
-    }
+    donate_to_holders(t, t->priority);
+    intr_set_level(old_level);
 }
 
 /** #Project 1: Priority Donation 쓰레드의 우선순위가 변경되었을 때, donation을 고려하여 우선순위를
  *  다시 결정하는 함수 */
 void refresh_priority(void) {
     /* 현재 쓰레드의 우선순위를 기부 받기 전의 우선순위로 변경.
-    현재 쓰레드의 waiters 리스트에서 가장 높은 우선순위를 현재 쓰레드의 우선순위와 비교 후 우선순위 결정 */
+    보유 중인 각 lock의 대기 힙 맨 위 쓰레드가 그 lock의 최대 기부자이므로, 기부자 수와 상관없이
+    보유한 lock 수만큼만 확인하여 우선순위 결정 */
     thread_t *t = thread_current();
-    t->priority = t->original_priority;
+    int priority = t->original_priority;
+    enum intr_level old_level = intr_disable();
 
-    if (list_empty(&t->donations))
-        return;
+    for (struct list_elem *e = list_begin(&t->held_locks); e != list_end(&t->held_locks); e = list_next(e)) {
+        struct heap *waiters = &list_entry(e, struct lock, elem)->semaphore.waiters;
+        donation_scan_cnt++;
+        if (!heap_empty(waiters)) {
+            thread_t *donor = heap_entry(heap_top(waiters), thread_t, wait_elem);
+            if (priority < donor->priority)
+                priority = donor->priority;
+        }
+    }
 
-    list_sort(&t->donations, cmp_priority, NULL);
+    /** #Project 1: Reader-Writer Lock 공유 모드로 보유 중인 rwlock에서 reader가 빠지기를 기다리는 writer의 기부 */
+    for (int i = 0; i < RW_HOLD_MAX; i++) {
+        struct rwlock *rw = t->read_holds[i].rw;
+        if (rw != NULL && rw->drainer != NULL && priority < rw->drainer->priority)
+            priority = rw->drainer->priority;
+    }
 
-    struct list_elem *max_elem = list_front(&t->donations);
-    thread_t *max_thread = list_entry(max_elem, thread_t, donation_elem);
+    /** #Priority Scheduling - Synchronization condition 대기 힙에 들어가 있을 수 있으므로 자리를 함께 옮김 */
+    thread_update_priority(t, priority);
+    intr_set_level(old_level);
+}
 
-    if (t->priority < max_thread->priority)
-        t->priority = max_thread->priority;
+/** #Project 1: Priority Donation 부팅 이후 refresh_priority 가 살펴본 보유 lock 수 */
+long long thread_donation_scans(void) {
+    enum intr_level old_level = intr_disable();
+    long long scans = donation_scan_cnt;
+    intr_set_level(old_level);
+    return scans;
 }
 
 /** #Project 1: Advanced Scheduler MLFQS Priority 계산하는 함수*/
@@ -799,22 +976,39 @@ void mlfqs_priority(struct thread *t) {
     if (t == idle_thread)
         return;
 
-    t->priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->niceness * 2));
+    mlfqs_recent_cpu(t);
+
+    int priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->niceness * 2));
+
+    if (priority > PRI_MAX)
+        priority = PRI_MAX;
+    else if (priority < PRI_MIN)
+        priority = PRI_MIN;
+    thread_update_priority(t, priority);
 }
 
-/** #Project 1: Advanced Scheduler MLFQS Recent Cpu 계산하는 함수 */
+/** #Project 1: Advanced Scheduler MLFQS Recent Cpu 에 놓친 감쇠를 모두 반영하는 함수 */
 void mlfqs_recent_cpu(struct thread *t) {
     if (t == idle_thread)
         return;
 
-    t->recent_cpu = add_mixed(mult_fp(div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1)), t->recent_cpu), t->niceness);
+    /* mlfqs_decay() catches up blocked threads before their history
+       is overwritten. */
+    ASSERT(decay_epoch - t->recent_cpu_epoch <= DECAY_HISTORY);
+
+    while (t->recent_cpu_epoch < decay_epoch) {
+        int coef = decay_coef[t->recent_cpu_epoch % DECAY_HISTORY];
+
+        t->recent_cpu = add_mixed(mult_fp(coef, t->recent_cpu), t->niceness);
+        t->recent_cpu_epoch++;
+    }
 }
 
 /** #Project 1: Advanced Scheduler MLFQS Load Average 계산하는 함수 */
 void mlfqs_load_avg(void) {
     int ready_threads;
 
-    ready_threads = list_size(&ready_list);
+    ready_threads = ready_cnt;
 
     if (thread_current() != idle_thread)
         ready_threads++;
@@ -830,28 +1024,64 @@ void mlfqs_increment(void) {
     thread_current()->recent_cpu = add_mixed(thread_current()->recent_cpu, 1);
 }
 
-/** #Project 1: Advanced Scheduler MLFQS 모든 Recent CPU 재계산 */
-void mlfqs_recalc_recent_cpu(void) {
-    struct list_elem *e = list_begin(&all_list);
-    thread_t *t = NULL;
-
-    while (e != list_end(&all_list)) {
-        t = list_entry(e, thread_t, all_elem);
+/** #Project 1: Advanced Scheduler MLFQS 1초마다 recent_cpu 감쇠
+ *  현재 load_avg 로 감쇠 계수를 기록하고 실행 중/ready 쓰레드만 즉시 반영한다.
+ *  block 된 쓰레드는 깨어날 때 mlfqs_recent_cpu()가 따라잡고, 그 전에 감쇠 기록이 덮일 쓰레드만
+ *  여기서 따라잡는다. ready 쓰레드는 우선순위별 큐에 들어 있고 새 load_avg 로 모두 우선순위가
+ *  바뀔 수 있으므로 여전히 매초 전부 다시 계산한다. 이 부분은 ready 쓰레드 수에 비례한다. */
+static void mlfqs_decay(void) {
+    /* The coefficient written below replaces the one for epoch
+       DECAY_EPOCH - DECAY_HISTORY.  Threads that blocked before that
+       epoch are at the front of STALE_LIST; each catches up and goes
+       to the back, which keeps the list in epoch order. */
+    while (!list_empty(&stale_list)) {
+        thread_t *t = list_entry(list_front(&stale_list), thread_t, stale_elem);
+
+        if (t->recent_cpu_epoch > decay_epoch - DECAY_HISTORY)
+            break;
         mlfqs_recent_cpu(t);
+        list_push_back(&stale_list, list_pop_front(&stale_list));
+    }
+
+    decay_coef[decay_epoch % DECAY_HISTORY] = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
+    decay_epoch++;
+
+    mlfqs_recent_cpu(thread_current());
+
+    /* Ready threads' priorities follow their decayed recent_cpu, which
+       may move them to another queue; a thread moved to a queue not
+       visited yet is just seen again, at no cost. */
+    for (int pri = PRI_MAX; pri >= PRI_MIN; pri--) {
+        struct list_elem *e = list_begin(&ready_queues[pri]);
 
-        e = list_next(e);
+        while (e != list_end(&ready_queues[pri])) {
+            thread_t *t = list_entry(e, thread_t, elem);
+
+            e = list_next(e);
+            mlfqs_priority(t);
+        }
     }
 }
 
-/** #Project 1: Advanced Scheduler MLFQS 모든 Priority 재계산 */
-void mlfqs_recalc_priority(void) {
-    struct list_elem *e = list_begin(&all_list);
-    thread_t *t = NULL;
+/** #Project 1: Advanced Scheduler 타이머 인터럽트마다 호출되는 MLFQS 갱신
+ *  4틱마다 recent_cpu 가 바뀐 쓰레드는 실행 중인 쓰레드뿐이므로 그것만 다시 계산한다. */
+void mlfqs_tick(int64_t ticks) {
+    uint64_t start = rdtsc();
 
-    while (e != list_end(&all_list)) {
-        t = list_entry(e, thread_t, all_elem);
-        mlfqs_priority(t);
+    mlfqs_increment();
 
-        e = list_next(e);
+    if (!(ticks % 4)) {
+        mlfqs_priority(thread_current());
+
+        if (!(ticks % TIMER_FREQ)) {
+            mlfqs_load_avg();
+            mlfqs_decay();
+        }
     }
+
+    uint64_t cycles = rdtsc() - start;
+    mlfqs_cycles += cycles;
+    if (cycles > mlfqs_cycles_max)
+        mlfqs_cycles_max = cycles;
+    mlfqs_update_cnt++;
 }
@@ -672,17 +672,26 @@ bool lazy_load_segment(struct page *page, void *aux)
 	// 1) 파일의 position을 ofs으로 지정한다.
 	file_seek(lazy_load_arg->file, lazy_load_arg->ofs);
 	// 2) 파일을 read_bytes만큼 물리 프레임에 읽어 들인다.
+	// 실패 시 프레임은 페이지가 파괴될 때 frame table에서 함께 회수된다.
 	if (file_read(lazy_load_arg->file, page->frame->kva, lazy_load_arg->page_read_bytes) != (int)(lazy_load_arg->page_read_bytes))
-	{
-		palloc_free_page(page->frame->kva);
 		return false;
-	}
 	// 3) 다 읽은 지점부터 zero_bytes만큼 0으로 채운다.make
 	memset(page->frame->kva + lazy_load_arg->page_read_bytes, 0, lazy_load_arg->page_zero_bytes);
 
 	return true;
 }
 
+/* Returns true if lazy_load_segment() arguments AUX_A and AUX_B
+ * load pages of the same segment of the same file. */
+bool lazy_load_same_segment(const void *aux_a, const void *aux_b)
+{
+	const struct container *a = aux_a;
+	const struct container *b = aux_b;
+
+	return a->file == b->file && a->seg_start == b->seg_start
+		&& a->seg_end == b->seg_end;
+}
+
 /* Loads a segment starting at offset OFS in FILE at address
  * UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
  * memory are initialized, as follows:
@@ -702,6 +711,9 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     ASSERT(pg_ofs(upage) == 0);
     ASSERT(ofs % PGSIZE == 0);
 
+    uint8_t *seg_start = upage;
+    uint8_t *seg_end = upage + read_bytes + zero_bytes;
+
     while (read_bytes > 0 || zero_bytes > 0) {
         /* Do calculate how to fill this page.
          * We will read PAGE_READ_BYTES bytes from FILE
@@ -716,7 +728,8 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
         aux ->page_read_bytes = page_read_bytes;
         aux ->page_zero_bytes = page_zero_bytes;
         aux ->writable = writable;
-        
+        aux ->seg_start = seg_start;
+        aux ->seg_end = seg_end;
 
         if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux))
             return false;
@@ -23,9 +23,6 @@
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
 
-/** #Project 2: System Call */
-struct lock filesys_lock;  // 파일 읽기/쓰기 용 lock
-
 /* System call.
  *
  * Previously system call services was handled by the interrupt handler
@@ -47,9 +44,6 @@ void syscall_init(void) {
      * until the syscall_entry swaps the userland stack to the kernel
      * mode stack. Therefore, we masked the FLAG_FL. */
     write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-
-    /** #Project 2: System Call - read & write 용 lock 초기화 */
-    lock_init(&filesys_lock);
 }
 
 /* The main system call interface */
@@ -58,6 +52,11 @@ void syscall_handler(struct intr_frame *f UNUSED) {
     // TODO: Your implementation goes here.
     int sys_number = f->R.rax;
 
+#ifdef VM
+    /** #Project 3: Stack Growth - 커널 모드에서 난 폴트도 사용자 스택 기준으로 판단 */
+    thread_current()->user_rsp = f->rsp;
+#endif
+
     // Argument 순서
     // %rdi %rsi %rdx %r10 %r8 %r9
 
@@ -231,9 +230,8 @@ int read(int fd, void *buffer, unsigned length) {
     // 그 외의 경우
     off_t bytes = -1;
 
-    lock_acquire(&filesys_lock);
+    /** #Project 4: 동기화는 inode 단위 reader/writer lock이 담당 */
     bytes = file_read(file, buffer, length);
-    lock_release(&filesys_lock);
 
     return bytes;
 }
@@ -261,9 +259,7 @@ int write(int fd, const void *buffer, unsigned length) {
         return length;
     }
 
-    lock_acquire(&filesys_lock);
     bytes = file_write(file, buffer, length);
-    lock_release(&filesys_lock);
 
     return bytes;
 }
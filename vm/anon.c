@@ -2,6 +2,12 @@
 
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include <bitmap.h>
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Number of disk sectors that hold one page. */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -9,6 +15,12 @@ static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
 
+/* Swap slots.  Bit I of SWAP_TABLE is set while page-sized slot I
+ * (sectors I * SECTORS_PER_PAGE ...) holds an evicted page. */
+static struct bitmap *swap_table;
+static struct lock swap_lock;
+static size_t swap_hint;        /* Where the next slot search starts. */
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
 	.swap_in = anon_swap_in,
@@ -21,7 +33,48 @@ static const struct page_operations anon_ops = {
 void
 vm_anon_init (void) {
 	/* TODO: Set up the swap_disk. */
-	swap_disk = NULL;
+	size_t slot_cnt = 0;
+
+	swap_disk = disk_get (1, 1);
+	if (swap_disk != NULL)
+		slot_cnt = disk_size (swap_disk) / SECTORS_PER_PAGE;
+
+	swap_table = bitmap_create (slot_cnt);
+	if (swap_table == NULL)
+		PANIC ("swap table creation failed");
+	lock_init (&swap_lock);
+	swap_hint = 0;
+}
+
+/* Claims a free swap slot and returns its index, or BITMAP_ERROR if the
+ * swap disk is full.  The search resumes where the previous one stopped
+ * and only wraps around to slot 0 when it runs off the end, so a run of
+ * allocations does not rescan the occupied prefix each time. */
+static size_t
+swap_slot_alloc (void) {
+	size_t slot;
+
+	lock_acquire (&swap_lock);
+	slot = bitmap_scan_and_flip (swap_table, swap_hint, 1, false);
+	if (slot == BITMAP_ERROR && swap_hint != 0)
+		slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
+	if (slot != BITMAP_ERROR)
+		swap_hint = slot + 1 < bitmap_size (swap_table) ? slot + 1 : 0;
+	lock_release (&swap_lock);
+
+	return slot;
+}
+
+/* Returns SLOT to the pool of free swap slots. */
+static void
+swap_slot_free (size_t slot) {
+	lock_acquire (&swap_lock);
+	ASSERT (bitmap_test (swap_table, slot));
+	bitmap_reset (swap_table, slot);
+	/* Prefer refilling holes low on the disk. */
+	if (slot < swap_hint)
+		swap_hint = slot;
+	lock_release (&swap_lock);
 }
 
 /* Initialize the file mapping */
@@ -31,22 +84,59 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->swap_slot = BITMAP_ERROR;
+	return true;
 }
 
 /* Swap in the page by read contents from the swap disk. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+	size_t slot = anon_page->swap_slot;
+	size_t i;
+
+	/* Never swapped out: the frame is already zeroed. */
+	if (slot == BITMAP_ERROR)
+		return true;
+
+	for (i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_read (swap_disk, slot * SECTORS_PER_PAGE + i,
+				(uint8_t *) kva + i * DISK_SECTOR_SIZE);
+
+	anon_page->swap_slot = BITMAP_ERROR;
+	swap_slot_free (slot);
+	return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+	size_t slot;
+	size_t i;
+
+	slot = swap_slot_alloc ();
+	if (slot == BITMAP_ERROR)
+		return false;
+
+	for (i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_write (swap_disk, slot * SECTORS_PER_PAGE + i,
+				(uint8_t *) page->frame->kva + i * DISK_SECTOR_SIZE);
+
+	anon_page->swap_slot = slot;
+	return true;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	/* First, since it waits for an eviction in progress to finish and
+	 * assign the swap slot. */
+	vm_free_frame (page);
+	if (anon_page->swap_slot != BITMAP_ERROR) {
+		swap_slot_free (anon_page->swap_slot);
+		anon_page->swap_slot = BITMAP_ERROR;
+	}
 }
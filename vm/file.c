@@ -44,6 +44,8 @@ file_backed_swap_out (struct page *page) {
 static void
 file_backed_destroy (struct page *page) {
 	struct file_page *file_page UNUSED = &page->file;
+
+	vm_free_frame (page);
 }
 
 /* Do the mmap */
@@ -1,14 +1,50 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "threads/vaddr.h"'
 #include "vm/uninit.h"
+#include "userprog/process.h"
 #include "threads/mmu.h"
 #include "lib/kernel/hash.h"
+#include <round.h>
+#include <stdio.h>
 #include <string.h>
 
+/* Frame table.  Every frame handed out from the user pool lives on
+ * FRAME_TABLE; when the pool runs dry the clock hand sweeps it looking
+ * for a frame whose accessed bit is clear (second chance). */
+static struct list frame_table;
+static struct list_elem *clock_hand;
+static struct lock frame_lock;
+static struct condition evict_done;  /* Signaled on FRAME_LOCK when an
+                                      * eviction finishes. */
+static size_t frame_cnt;        /* # of frames on FRAME_TABLE. */
+
+/* Object caches for struct page and struct frame.  Through malloc() both
+ * would take 128-byte blocks; a slab fits them at their exact size. */
+static struct slab_cache page_slab;
+static struct slab_cache frame_slab;
+
+/* Eviction statistics. */
+static long long evict_cnt;       /* # of frames evicted. */
+static long long clock_scan_cnt;  /* # of frames inspected by the clock. */
+
+/* Fault-around.  When a lazily loaded page faults, up to
+ * FAULT_AROUND_PAGES of the pages that follow it in the same segment are
+ * loaded and mapped as well.  0, the default, keeps loading strictly on
+ * demand.  Set with -fa=N on the kernel command line. */
+size_t fault_around_pages;
+static long long fault_around_cnt;   /* # of pages mapped ahead. */
+static long long fault_avoided_cnt;  /* # of those later touched. */
+
+/* Stack growth.  The user stack may grow down from USER_STACK to at most
+ * STACK_LIMIT_PAGES pages (1 MB by default).  Set with -sl=N on the
+ * kernel command line. */
+size_t stack_limit_pages = 256;
+
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -22,6 +58,44 @@ vm_init (void) {
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
+	list_init (&frame_table);
+	lock_init (&frame_lock);
+	cond_init (&evict_done);
+	clock_hand = list_end (&frame_table);
+	slab_cache_init (&page_slab, "page", sizeof (struct page));
+	slab_cache_init (&frame_slab, "frame", sizeof (struct frame));
+}
+
+/* Prints frame table statistics. */
+void
+vm_print_stats (void) {
+	printf ("Frame: %lld evictions, %lld clock scans", evict_cnt,
+			clock_scan_cnt);
+	if (evict_cnt > 0)
+		printf (" (%lld.%02lld scans/eviction)", clock_scan_cnt / evict_cnt,
+				clock_scan_cnt * 100 / evict_cnt % 100);
+	printf ("\n");
+	if (fault_around_pages > 0)
+		printf ("Fault-around: %lld pages mapped ahead, %lld faults avoided\n",
+				fault_around_cnt, fault_avoided_cnt);
+	slab_print_stats (&page_slab);
+	slab_print_stats (&frame_slab);
+	/* Pages held for page and frame records per frame in use, at their
+	 * peaks: first the slab pages actually held, then the arena pages
+	 * malloc () would need for the same objects, packed as tightly as it
+	 * can, for comparison. */
+	if (frame_slab.peak_in_use > 0) {
+		size_t slab_pages = page_slab.peak_slab_cnt + frame_slab.peak_slab_cnt;
+		size_t malloc_pages =
+			DIV_ROUND_UP (page_slab.peak_in_use,
+					malloc_blocks_per_page (sizeof (struct page)))
+			+ DIV_ROUND_UP (frame_slab.peak_in_use,
+					malloc_blocks_per_page (sizeof (struct frame)));
+		printf ("VM metadata: %zu bytes per resident page at peak "
+				"(malloc: at least %zu)\n",
+				slab_pages * PGSIZE / frame_slab.peak_in_use,
+				malloc_pages * PGSIZE / frame_slab.peak_in_use);
+	}
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -41,7 +115,9 @@ page_get_type (struct page *page) {
 /* Helpers */
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_map_frame (struct page *page, struct frame *frame);
 static struct frame *vm_evict_frame (void);
+static void spt_destroy_page (struct hash_elem *e, void *aux);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -70,7 +146,9 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 			여기에서 원하는 것은 uninit page 생성 후 spt에 삽입*/
 
 		// 1. 페이지 할당 
-		struct page * page = (struct page*)malloc(sizeof(struct page));
+		struct page * page = slab_alloc (&page_slab);
+		if (page == NULL)
+			goto err;
 
 		// 2. 함수 포인터  
 		bool (*initializer)(struct page *, enum vm_type, void *);
@@ -85,6 +163,8 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		uninit_new (page, upage, init, type, aux, initializer);
 
 		page->writable = writable; 
+		page->owner = thread_current ();
+		page->prefetched = false;
 
 		return spt_insert_page(spt,page);
 
@@ -99,12 +179,11 @@ struct page *
 spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	struct hash *h = &spt->spt_hash;
 
-	// 페이지 할당  - page va 대입 - hash find 함수 - return hash_elem
-	struct page *p = (struct page *)malloc(sizeof(struct page));
+	// 검색용 페이지 - page va 대입 - hash find 함수 - return hash_elem
+	struct page p;
 
-	p->va = pg_round_down(va);
-	struct hash_elem *e = hash_find (h, &p->hash_elem);
-	free(p);
+	p.va = pg_round_down(va);
+	struct hash_elem *e = hash_find (h, &p.hash_elem);
 
 	if(e != NULL){
 		return hash_entry(e, struct page, hash_elem);
@@ -131,62 +210,407 @@ spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
 	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Records that PAGE maps FRAME.  FRAME_LOCK must be held. */
+static void
+frame_attach (struct frame *frame, struct page *page) {
+	list_push_back (&frame->pages, &page->share_elem);
+	frame->share_cnt++;
+	if (frame->page == NULL)
+		frame->page = page;
+	page->frame = frame;
+}
+
+/* Drops PAGE from the pages mapping FRAME and returns how many still map
+ * it.  FRAME->PAGE always names one of the remaining pages.
+ * FRAME_LOCK must be held. */
+static int
+frame_detach (struct frame *frame, struct page *page) {
+	list_remove (&page->share_elem);
+	page->frame = NULL;
+	if (--frame->share_cnt == 0)
+		frame->page = NULL;
+	else if (frame->page == page)
+		frame->page = list_entry (list_front (&frame->pages), struct page,
+				share_elem);
+	return frame->share_cnt;
+}
+
+/* Removes FRAME, which no page maps any more, from the frame table and
+ * frees it.  FRAME_LOCK must be held. */
+static void
+frame_release (struct frame *frame) {
+	ASSERT (frame->share_cnt == 0);
+
+	if (clock_hand == &frame->frame_elem)
+		clock_hand = list_next (clock_hand);
+	list_remove (&frame->frame_elem);
+	frame_cnt--;
+
+	palloc_free_page (frame->kva);
+	slab_free (&frame_slab, frame);
+}
+
+/* Counts a fault avoided if PAGE was mapped by fault-around and has since
+ * been touched.  Must be called before PAGE's accessed bit is cleared or
+ * its mapping dropped.  FRAME_LOCK must be held. */
+static void
+frame_note_access (struct page *page, uint64_t *pml4) {
+	if (page->prefetched && pml4_is_accessed (pml4, page->va)) {
+		page->prefetched = false;
+		fault_avoided_cnt++;
+	}
+}
+
+/* Returns true if any page mapping FRAME has been accessed since the
+ * last call, clearing the accessed bits as it goes.
+ * FRAME_LOCK must be held. */
+static bool
+frame_accessed (struct frame *frame) {
+	bool accessed = false;
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages);
+			e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		frame_note_access (page, pml4);
+		if (pml4_is_accessed (pml4, page->va)) {
+			pml4_set_accessed (pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Get the struct frame, that will be evicted.
+ * Must be called with FRAME_LOCK held.  The hand clears the accessed bits
+ * of every frame it passes, those of all the pages sharing it
+ * copy-on-write included, so two full sweeps always find a victim unless
+ * every frame is pinned. */
 static struct frame *
 vm_get_victim (void) {
 	struct frame *victim = NULL;
 	 /* TODO: The policy for eviction is up to you. */
+	size_t i;
+
+	for (i = 0; i < 2 * frame_cnt; i++) {
+		if (clock_hand == list_end (&frame_table))
+			clock_hand = list_begin (&frame_table);
 
+		struct frame *frame = list_entry (clock_hand, struct frame, frame_elem);
+		clock_hand = list_next (clock_hand);
+		clock_scan_cnt++;
+
+		if (frame->pinned || frame_accessed (frame))
+			continue;
+		victim = frame;
+		break;
+	}
 	return victim;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+/* Waits while PAGE's frame is being evicted.  Afterward PAGE either has
+ * no frame or is mapped again, the write-out having failed.
+ * FRAME_LOCK must be held. */
+static void
+frame_wait_evict (struct page *page) {
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait (&evict_done, &frame_lock);
+}
+
+/* Evict one frame and return it, pinned.  Every page sharing the frame
+ * copy-on-write is written out to a swap slot of its own, as each would
+ * have taken its own copy on its next write anyway.
+ * Return NULL on error.
+ * Must be called with FRAME_LOCK held.  The lock is released while the
+ * pages are written out, so other faults and frame allocations do not
+ * wait for the swap disk; the victim is pinned and marked evicting
+ * meanwhile, and anyone who needs one of its pages, or would add or drop
+ * a sharer, waits in frame_wait_evict (). */
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
+	struct frame *victim = vm_get_victim ();
+	struct list_elem *e;
+	size_t swapped = 0;
 	/* TODO: swap out the victim and return the evicted frame. */
+	if (victim == NULL)
+		return NULL;
+
+	/* Unmap first so the owners fault, and wait for the eviction,
+	 * instead of writing to the frame while it is being written out. */
+	for (e = list_begin (&victim->pages); e != list_end (&victim->pages);
+			e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		pml4_clear_page (page->owner->pml4, page->va);
+	}
+	victim->pinned = true;
+	victim->evicting = true;
+	lock_release (&frame_lock);
+
+	for (e = list_begin (&victim->pages); e != list_end (&victim->pages);
+			e = list_next (e)) {
+		if (!swap_out (list_entry (e, struct page, share_elem)))
+			break;
+		swapped++;
+	}
+
+	lock_acquire (&frame_lock);
+	/* The pages written out, at the front of the list, leave the frame.
+	 * If the swap disk filled up, the rest are mapped again and keep it;
+	 * read-only while it is still shared. */
+	while (swapped-- > 0)
+		frame_detach (victim, list_entry (list_front (&victim->pages),
+					struct page, share_elem));
+	for (e = list_begin (&victim->pages); e != list_end (&victim->pages);
+			e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, share_elem);
+		pml4_set_page (page->owner->pml4, page->va, victim->kva,
+				page->writable && victim->share_cnt == 1);
+	}
 
-	return NULL;
+	bool success = victim->share_cnt == 0;
+	if (success)
+		evict_cnt++;
+	else
+		victim->pinned = false;
+	victim->evicting = false;
+	cond_broadcast (&evict_done, &frame_lock);
+	return success ? victim : NULL;
+}
+
+/* Returns a pinned frame taken straight from the user pool, or NULL if
+ * the pool is empty.  Never evicts. */
+static struct frame *
+vm_get_free_frame (void) {
+	struct frame *frame;
+	void *kva = palloc_get_page (PAL_USER | PAL_ZERO);
+
+	if (kva == NULL)
+		return NULL;
+	frame = slab_alloc (&frame_slab);
+	if (frame == NULL) {
+		palloc_free_page (kva);
+		return NULL;
+	}
+	frame->kva = kva;
+	frame->page = NULL;
+	list_init (&frame->pages);
+	frame->share_cnt = 0;
+	frame->pinned = true;
+	frame->evicting = false;
+
+	/* New frames go just behind the hand, so they get a full
+	 * revolution before they are considered. */
+	lock_acquire (&frame_lock);
+	list_insert (clock_hand, &frame->frame_elem);
+	frame_cnt++;
+	lock_release (&frame_lock);
+	return frame;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
  * space.
- * Gets a new physical page from the user pool by calling palloc_get_page.
- * When successfully got a page from the user pool, also allocates a frame,initialize its members, and returns it.
- * After you implement vm_get_frame, you have to allocate all user space pages (PALLOC_USER) through this function.
- * You don't need to handle swap out for now in case of page allocation failure. Just mark those case with PANIC ("todo") for now.
-*/
+ * The returned frame is pinned; the caller unpins it once the page contents
+ * are in place.  Returns NULL only if no frame can be evicted or the victim
+ * could not be written out. */
 static struct frame *
-vm_get_frame(void)
-{
-    // 프레임 구조체 할당
-    struct frame *frame = malloc(sizeof(struct frame));
-    ASSERT(frame != NULL);
+vm_get_frame (void) {
+	struct frame *frame = vm_get_free_frame ();
 
-    frame->kva = palloc_get_page(PAL_USER | PAL_ZERO);
+	if (frame != NULL)
+		return frame;
 
-    if (frame->kva == NULL)
-        frame = vm_evict_frame();
+	lock_acquire (&frame_lock);
+	frame = vm_evict_frame ();
+	if (frame != NULL) {
+		memset (frame->kva, 0, PGSIZE);
+		frame->pinned = true;
+	}
+	lock_release (&frame_lock);
 
+	ASSERT (frame == NULL || frame->page == NULL);
+	return frame;
+}
 
-    frame->page = NULL; // 초기에는 연결된 페이지가 없음
+/* Detaches PAGE from its frame, if any, and unmaps it from the owner's
+ * page table.  The frame goes back to the user pool once no other page
+ * shares it. */
+void
+vm_free_frame (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame_wait_evict (page);
+	frame = page->frame;
+	if (frame != NULL) {
+		if (page->owner->pml4 != NULL) {
+			frame_note_access (page, page->owner->pml4);
+			pml4_clear_page (page->owner->pml4, page->va);
+		}
+		if (frame_detach (frame, page) == 0)
+			frame_release (frame);
+	}
+	lock_release (&frame_lock);
+}
 
-    ASSERT(frame->page == NULL);
+/* Makes DST, a page of the current (child) process, share SRC's frame
+ * copy-on-write.  SRC is faulted back in first if it has been evicted.
+ * Both mappings become read-only; the first write through either one
+ * takes a private copy in vm_handle_wp (). */
+static bool
+vm_share_frame (struct page *src, struct page *dst) {
+	for (;;) {
+		lock_acquire (&frame_lock);
+		frame_wait_evict (src);
+		struct frame *frame = src->frame;
+		if (frame != NULL) {
+			bool success = pml4_set_page (dst->owner->pml4, dst->va,
+					frame->kva, false);
+			if (success) {
+				frame_attach (frame, dst);
+				pml4_clear_page (src->owner->pml4, src->va);
+				pml4_set_page (src->owner->pml4, src->va, frame->kva, false);
+			}
+			lock_release (&frame_lock);
+			return success;
+		}
+		lock_release (&frame_lock);
 
-    return frame; // 초기화된 프레임 반환
+		if (!vm_do_claim_page (src))
+			return false;
+	}
 }
 
-/* Growing the stack. */
+/* Returns true if a not-present fault at ADDR, taken with the user
+ * stack pointer at RSP, looks like an access to the stack: within the
+ * stack limit and no lower than the 8 bytes a PUSH writes below RSP. */
+static bool
+is_stack_access (void *addr, uintptr_t rsp) {
+	uintptr_t va = (uintptr_t) addr;
+
+	return va < USER_STACK
+		&& va >= USER_STACK - stack_limit_pages * PGSIZE
+		&& va + 8 >= rsp;
+}
+
+/* Growing the stack.
+ * Registers a zero-filled stack page for every unmapped page from ADDR
+ * up to the current bottom of the stack, so a frame that skips several
+ * pages (a large local array, say) is set up in one step instead of
+ * leaving holes.  Only the page at ADDR is claimed by the caller; the
+ * others fault in when first touched. */
 static void
-vm_stack_growth (void *addr UNUSED) {
+vm_stack_growth (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	uint8_t *va = pg_round_down (addr);
+
+	for (; va < (uint8_t *) USER_STACK && spt_find_page (spt, va) == NULL;
+			va += PGSIZE)
+		if (!vm_alloc_page (VM_ANON | VM_MARKER_0, va, true))
+			break;
 }
 
-/* Handle the fault on write_protected page */
+/* Handle the fault on write_protected page.
+ * PAGE is logically writable but mapped read-only because its frame is
+ * shared copy-on-write.  The last sharer simply regains write access;
+ * any other sharer moves to a private copy of the frame. */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_handle_wp (struct page *page) {
+	uint64_t *pml4 = page->owner->pml4;
+	struct frame *old, *new;
+
+	lock_acquire (&frame_lock);
+	frame_wait_evict (page);
+	old = page->frame;
+	if (old == NULL) {
+		/* Evicted before we got here; the retried access faults it in. */
+		lock_release (&frame_lock);
+		return true;
+	}
+	if (old->share_cnt == 1) {
+		pml4_clear_page (pml4, page->va);
+		pml4_set_page (pml4, page->va, old->kva, true);
+		lock_release (&frame_lock);
+		return true;
+	}
+	lock_release (&frame_lock);
+
+	/* Getting a frame may evict, so it cannot be done under FRAME_LOCK. */
+	new = vm_get_frame ();
+	if (new == NULL)
+		return false;
+
+	lock_acquire (&frame_lock);
+	old = page->frame;
+	if (old == NULL || old->share_cnt == 1) {
+		/* The other sharers left, or our now-private frame was evicted,
+		 * while we were allocating.  Either way no copy is needed: the
+		 * retried access upgrades the mapping or faults the page in. */
+		if (old != NULL) {
+			pml4_clear_page (pml4, page->va);
+			pml4_set_page (pml4, page->va, old->kva, true);
+		}
+		frame_release (new);
+		lock_release (&frame_lock);
+		return true;
+	}
+
+	memcpy (new->kva, old->kva, PGSIZE);
+	frame_detach (old, page);
+	frame_attach (new, page);
+	pml4_clear_page (pml4, page->va);
+	bool success = pml4_set_page (pml4, page->va, new->kva, true);
+	new->pinned = false;
+	lock_release (&frame_lock);
+
+	if (!success)
+		vm_free_frame (page);
+	return success;
+}
+
+/* Maps the pages that follow PAGE, which was just loaded by
+ * lazy_load_segment() with argument SEGMENT, while they are still
+ * waiting to be loaded from the same segment of the same executable.
+ * Adjacent segments with the same permissions are left alone.  Stops
+ * after FAULT_AROUND_PAGES pages or as soon as the user pool is empty,
+ * so fault-around never evicts anything to make room. */
+static void
+vm_fault_around (struct supplemental_page_table *spt, struct page *page,
+		void *segment) {
+	uint8_t *va = page->va;
+	size_t i;
+
+	for (i = 0; i < fault_around_pages; i++) {
+		va += PGSIZE;
+		if (!is_user_vaddr (va))
+			break;
+
+		struct page *next = spt_find_page (spt, va);
+		if (next == NULL || VM_TYPE (next->operations->type) != VM_UNINIT
+				|| next->uninit.init != lazy_load_segment
+				|| !lazy_load_same_segment (next->uninit.aux, segment))
+			break;
+
+		struct frame *frame = vm_get_free_frame ();
+		if (frame == NULL)
+			break;
+
+		/* On failure put the page back as it was, so a real fault on it
+		 * retries the load and reports the error. */
+		const struct page_operations *ops = next->operations;
+		struct uninit_page uninit = next->uninit;
+		if (!vm_map_frame (next, frame)) {
+			vm_free_frame (next);
+			next->operations = ops;
+			next->uninit = uninit;
+			break;
+		}
+		next->prefetched = true;
+		fault_around_cnt++;
+	}
 }
 
 /* Return true on success */
@@ -199,27 +623,57 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED, bool user U
 
 	// printf("🚨 Address: %p\n", addr);
 
-	if(not_present){
-		//  사실상 이 부분이 핵심 (페이지를 구해야 하기 떄문에)
-		page = spt_find_page(spt,addr);
-		if(page == NULL){
+	if (addr == NULL || is_kernel_vaddr (addr))
+		return false;
+
+	page = spt_find_page (spt, addr);
+	if (page == NULL && not_present) {
+		/* A fault in kernel mode comes from a system call touching a
+		 * user buffer; F->RSP is then the kernel stack, so use the user
+		 * RSP saved on entry to the system call. */
+		uintptr_t rsp = user ? f->rsp : thread_current ()->user_rsp;
+		if (!is_stack_access (addr, rsp))
 			return false;
-		}
-		// if(write==1 && page->writable == 0){
-		// 	return false ;
-		// }
-		return vm_do_claim_page (page);
+		vm_stack_growth (addr);
+		page = spt_find_page (spt, addr);
 	}
-	
-	return false ;
+	if (page == NULL)
+		return false;
+
+	/* Write to a present page: only copy-on-write sharing is resolvable. */
+	if (!not_present)
+		return write && page->writable && vm_handle_wp (page);
+
+	if (write && !page->writable)
+		return false;
+
+	/* Remember the segment before claiming transmutes the page. */
+	void *segment = NULL;
+	if (VM_TYPE (page->operations->type) == VM_UNINIT
+			&& page->uninit.init == lazy_load_segment)
+		segment = page->uninit.aux;
+
+	//  사실상 이 부분이 핵심 (페이지를 구해야 하기 떄문에)
+	if (!vm_do_claim_page (page))
+		return false;
+
+	if (segment != NULL && fault_around_pages > 0)
+		vm_fault_around (spt, page, segment);
+	return true;
 }
 
-/* Free the page.
- * DO NOT MODIFY THIS FUNCTION. */
+/* Free the page. */
 void
 vm_dealloc_page (struct page *page) {
 	destroy (page);
-	free (page);
+	slab_free (&page_slab, page);
+}
+
+/* Hash destructor for supplemental_page_table_kill: frees the page that
+ * contains E. */
+static void
+spt_destroy_page (struct hash_elem *e, void *aux UNUSED) {
+	vm_dealloc_page (hash_entry (e, struct page, hash_elem));
 }
 
 /* Claim the page that allocate on VA. */
@@ -253,43 +707,47 @@ vm_claim_page (void *va UNUSED) {
  */
 static bool
 vm_do_claim_page (struct page *page) {
-	struct frame *frame = vm_get_frame ();
+	bool resident;
 
+	/* A page whose eviction is under way faults too; once the eviction
+	 * is over it is either swapped out or mapped again. */
+	lock_acquire (&frame_lock);
+	frame_wait_evict (page);
+	resident = page->frame != NULL;
+	lock_release (&frame_lock);
+	if (resident)
+		return true;
 
-	// if (!frame || !frame->kva) {
-    // PANIC("🚨 Invalid frame returned by vm_get_frame!");
-	// }
-	// if (!page || !page->va) {
-    // PANIC("🚨 Invalid page structure!");
-	// }	
-	// if (page == NULL || frame == NULL) {
-	// 	PANIC("🚨 NULL pointer exception at page or frame!");
-	// }
-
+	struct frame *frame = vm_get_frame ();
 
 	if(frame == NULL){
 		return false;
 	}
+	return vm_map_frame (page, frame);
+}
 
+/* Maps PAGE to FRAME, which vm_get_frame () or vm_get_free_frame ()
+ * returned pinned, and loads the page contents into it. */
+static bool
+vm_map_frame (struct page *page, struct frame *frame) {
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	lock_acquire (&frame_lock);
+	frame_attach (frame, page);
+	lock_release (&frame_lock);
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
 	// * 페이지 테이블의 실제 주소에 가상 주소의 매핑
 
-	struct thread *t = thread_current();
-	bool success = pml4_set_page(t->pml4,page->va,frame->kva, page->writable);
-	
-	if (success){
-		return swap_in (page, frame->kva);
-	}else{
-		palloc_free_page(frame->kva);
-		free(frame);
+	if (!pml4_set_page (page->owner->pml4, page->va, frame->kva, page->writable)) {
+		vm_free_frame (page);
 		return false;
-	}	
-	return false;
-	
+	}
+
+	/* The frame stays pinned until its contents are loaded, so the clock
+	 * never picks a half-filled frame. */
+	bool success = swap_in (page, frame->kva);
+	frame->pinned = false;
+	return success;
 }
 
 /* Initialize new supplemental page table */
@@ -304,7 +762,10 @@ bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
 
-	// 스택에 객체 생성 
+	/* Resident pages are not copied: the child maps the parent's frame
+	 * read-only and the copy happens on the first write (see
+	 * vm_handle_wp), so fork costs one SPT entry per page rather than
+	 * one page copy. */
 	struct hash_iterator i; 
 	hash_first(&i,&src->spt_hash);
   
@@ -319,7 +780,8 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		if(type == VM_UNINIT){
 			vm_initializer *init = (&src_page->uninit)->init;
 			void *aux = (&src_page->uninit)->aux;
-			vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_0, upage, writable, init, aux);
+			if (!vm_alloc_page_with_initializer(src_page->uninit.type, upage, writable, init, aux))
+				return false;
 			continue;
 		}
 
@@ -328,13 +790,12 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 			return false ; 	
 		}
 
-		// VA를 PA와 매핑
-		if(!vm_claim_page(upage)){
-			return false ;
-		}
-
+		// 프레임 없이 타입만 초기화한 뒤 부모의 프레임을 공유
 		struct page *dst_page = spt_find_page(dst,upage);
-		memcpy(dst_page->frame->kva,src_page->frame->kva,PGSIZE);
+		if (!swap_in (dst_page, NULL))
+			return false;
+		if (!vm_share_frame (src_page, dst_page))
+			return false;
 	}
 
 	return true;
@@ -346,7 +807,7 @@ supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
 
-	hash_clear (&spt->spt_hash, hash_page_destory);
+	hash_clear (&spt->spt_hash, spt_destroy_page);
 
 }
 